@@ -0,0 +1,47 @@
+#ifndef ARENA_ALLOCATOR_H
+#define ARENA_ALLOCATOR_H
+
+#include <stddef.h>
+
+#include "memory.h"
+
+/*
+    Standard allocator that pushes into an arena, so std containers can use scratch memory.
+    deallocate does nothing, the memory goes away with the arena or the temporary memory scope
+    it was pushed in. Containers using it must not outlive that scope.
+*/
+template<typename T>
+struct arena_allocator
+{
+    typedef T value_type;
+
+    memory_arena* m_arena;
+
+    arena_allocator(memory_arena* arena) : m_arena(arena) {}
+
+    template<typename U>
+    arena_allocator(const arena_allocator<U>& other) : m_arena(other.m_arena) {}
+
+    T* allocate(size_t count)
+    {
+        T* result = push_array<T>(m_arena, count);
+        assert(result);
+        return result;
+    }
+
+    void deallocate(T* p, size_t count) {}
+};
+
+template<typename T, typename U>
+inline bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b)
+{
+    return a.m_arena == b.m_arena;
+}
+
+template<typename T, typename U>
+inline bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b)
+{
+    return a.m_arena != b.m_arena;
+}
+
+#endif
@@ -1,54 +1,393 @@
 #include "asset.h"
 
+#include <stdio.h>
+#include <SDL_mutex.h>
 
 /*
-    I'll allocate 1 large memory buffer for all asset paths. I will limit asset paths to 256 bytes for now.
-    So, a new string starts every 256 bytes. first string starts at byte 0, second at byte 256 and so on.
+    Open addressing table with Robin Hood probing. Every slot keeps the full 64 bit hash of its path,
+    so a probe only touches the string pool when the hashes already match. Paths are packed back to
+    back in their own arena and entries refer to them by offset. Slots move around as others are
+    inserted, the entries they point to don't, so an asset_id is the index of its entry.
+    A hash of 0 marks an empty slot, real hashes are never 0.
 */
-static char*      asset_storage;
-static asset_tag* asset_tags;
-static uint32_t   num_assets;
+struct asset_slot
+{
+    uint64_t hash;
+    uint32_t entry;
+};
 
-void asset_storage_init()
+static memory_arena*        asset_arena;
+static memory_arena*        asset_path_arena;
+static asset_slot*          asset_slots;
+static uint32_t             asset_capacity;
+//entry 0 is the head of the LRU list, oldest release first
+static asset_entry*         asset_entries;
+static uint32_t             num_assets;
+static asset_evict_function evict_functions[NUM_ASSET_TYPES];
+static uint64_t             cpu_resident;
+static uint64_t             gpu_resident;
+static uint64_t             cpu_budget;
+static uint64_t             gpu_budget;
+//job threads look textures up while the main thread adds and evicts them
+static SDL_mutex*           asset_mutex;
+
+static inline uint32_t probe_distance(uint64_t hash, uint32_t index)
+{
+    uint32_t home = (uint32_t)hash & (asset_capacity - 1);
+    return (index - home) & (asset_capacity - 1);
+}
+
+static asset_slot* allocate_slots(uint32_t capacity)
 {
-    num_assets = 0;
-    uint64_t storage_size = MAX_NUM_ASSETS * MAX_ASSET_PATH_LENGTH;
+    asset_slot* result = push_array<asset_slot>(asset_arena, capacity, CACHE_LINE_SIZE);
+    if (result)
+    {
+        memset(result, 0, capacity * sizeof(asset_slot));
+    }
+    return result;
+}
 
-    asset_storage = (char*)push_size(storage_size);
-    asset_tags    = (asset_tag*)push_size(MAX_NUM_ASSETS*sizeof(asset_tag));
+//richer slots hand their place to poorer ones, so probe lengths stay short and even
+static void insert_slot(asset_slot slot)
+{
+    uint32_t mask     = asset_capacity - 1;
+    uint32_t index    = (uint32_t)slot.hash & mask;
+    uint32_t distance = 0;
 
-    memset(asset_storage, 0, storage_size);
-    memset(asset_tags, 0, MAX_NUM_ASSETS*sizeof(asset_tag));
+    while (asset_slots[index].hash != 0)
+    {
+        uint32_t existing_distance = probe_distance(asset_slots[index].hash, index);
+        if (existing_distance < distance)
+        {
+            asset_slot temp = asset_slots[index];
+            asset_slots[index] = slot;
+            slot = temp;
+            distance = existing_distance;
+        }
+        index = (index + 1) & mask;
+        distance++;
+    }
+    asset_slots[index] = slot;
 }
 
 /*
-    searches the asset storage for the asset. If not found, adds the asset to storage, and return the same index
-    otherwise, returns the index of the component which has already loaded the data (for data sharing).
+    The old slot array stays behind in the arena, the arena can't give it back. Since the table
+    doubles, all the old arrays together are never bigger than the current one.
 */
-asset_tag find_asset_in_storage(const char* asset_path, asset_tag tag)
+static bool grow_asset_table(void)
+{
+    asset_slot* old_slots    = asset_slots;
+    uint32_t    old_capacity = asset_capacity;
+
+    asset_slot* new_slots = allocate_slots(old_capacity * 2);
+    if (!new_slots)
+    {
+        return false;
+    }
+
+    asset_slots    = new_slots;
+    asset_capacity = old_capacity * 2;
+    for (uint32_t i = 0; i < old_capacity; ++i)
+    {
+        if (old_slots[i].hash != 0)
+        {
+            insert_slot(old_slots[i]);
+        }
+    }
+    return true;
+}
+
+static int32_t find_slot(uint64_t hash, const char* asset_path, uint32_t length)
+{
+    uint32_t mask     = asset_capacity - 1;
+    uint32_t index    = (uint32_t)hash & mask;
+    uint32_t distance = 0;
+
+    while (asset_slots[index].hash != 0)
+    {
+        asset_slot* slot = asset_slots + index;
+        //past this point the path would already have displaced the slot we are looking at
+        if (probe_distance(slot->hash, index) < distance)
+        {
+            break;
+        }
+        if (slot->hash == hash)
+        {
+            if (!asset_path)
+            {
+                return (int32_t)index;
+            }
+            asset_entry* entry = asset_entries + slot->entry;
+            if (entry->key_length == length &&
+                memcmp(asset_path_arena->base + entry->key_offset, asset_path, length) == 0)
+            {
+                return (int32_t)index;
+            }
+        }
+        index = (index + 1) & mask;
+        distance++;
+    }
+    return -1;
+}
+
+void asset_storage_init()
+{
+    asset_mutex      = SDL_CreateMutex();
+    num_assets       = 0;
+    asset_capacity   = ASSET_TABLE_INITIAL_SIZE;
+    asset_arena      = create_sub_arena("assets", ASSET_MEMORY_BUDGET);
+    asset_path_arena = create_sub_arena("asset paths", ASSET_PATH_MEMORY_BUDGET);
+    asset_slots      = allocate_slots(asset_capacity);
+    asset_entries    = push_array<asset_entry>(asset_arena, MAX_NUM_ASSETS + 1, CACHE_LINE_SIZE);
+    memset(asset_entries, 0, sizeof(asset_entry));
+    memset(evict_functions, 0, sizeof(evict_functions));
+    cpu_resident = 0;
+    gpu_resident = 0;
+    cpu_budget   = ASSET_CPU_BUDGET;
+    gpu_budget   = ASSET_GPU_BUDGET;
+    //evictable assets keep their memory in freeable arenas
+    block_memory_init();
+}
+
+uint64_t asset_path_hash(const char* asset_path)
+{
+    uint64_t hash = hash64(asset_path, strlen(asset_path));
+    //0 is reserved for empty slots
+    return hash ? hash : 1;
+}
+
+//returns the entry of the path, 0 if it isn't there and can't be added
+static uint32_t find_or_add_asset(const char* asset_path, asset_type type)
+{
+    uint32_t length = (uint32_t)strlen(asset_path);
+    uint64_t hash   = asset_path_hash(asset_path);
+
+    int32_t found = find_slot(hash, asset_path, length);
+    if (found >= 0)
+    {
+        return asset_slots[found].entry;
+    }
+
+    if (num_assets == MAX_NUM_ASSETS)
+    {
+        printf("Too many assets, can not add %s\n", asset_path);
+        return 0;
+    }
+    if ((uint64_t)(num_assets + 1) * 100 > (uint64_t)asset_capacity * ASSET_TABLE_MAX_LOAD)
+    {
+        //a full table still works, just with longer probes, so only give up when there is no slot left
+        if (!grow_asset_table() && num_assets + 1 == asset_capacity)
+        {
+            printf("Asset table is full, can not add %s\n", asset_path);
+            return 0;
+        }
+    }
+
+    char* key = (char*)push_size(asset_path_arena, length, 1);
+    if (!key)
+    {
+        return 0;
+    }
+    memcpy(key, asset_path, length);
+
+    uint32_t index = ++num_assets;
+    asset_entry* entry = asset_entries + index;
+    memset(entry, 0, sizeof(asset_entry));
+    entry->hash       = hash;
+    entry->key_offset = (uint32_t)((uint8_t*)key - asset_path_arena->base);
+    entry->key_length = length;
+    entry->type       = type;
+
+    asset_slot slot = {};
+    slot.hash  = hash;
+    slot.entry = index;
+    insert_slot(slot);
+    return index;
+}
+
+static inline bool is_entry_loaded(asset_entry* entry)
+{
+    return entry->data != NULL || entry->gpu_name != 0;
+}
+
+static void remove_from_lru(uint32_t index)
+{
+    asset_entry* entry = asset_entries + index;
+    asset_entries[entry->lru_prev].lru_next = entry->lru_next;
+    asset_entries[entry->lru_next].lru_prev = entry->lru_prev;
+    entry->lru_prev = 0;
+    entry->lru_next = 0;
+}
+
+//the newest release goes last, eviction starts at the front
+static void add_to_lru(uint32_t index)
+{
+    asset_entry* head  = asset_entries;
+    asset_entry* entry = asset_entries + index;
+    entry->lru_prev = head->lru_prev;
+    entry->lru_next = 0;
+    asset_entries[head->lru_prev].lru_next = index;
+    head->lru_prev = index;
+}
+
+asset_id acquire_asset(const char* asset_path, asset_type type)
+{
+    SDL_LockMutex(asset_mutex);
+    uint32_t index = find_or_add_asset(asset_path, type);
+    SDL_UnlockMutex(asset_mutex);
+    if (!index)
+    {
+        return 0;
+    }
+
+    asset_entry* entry = asset_entries + index;
+    if (entry->type != type)
+    {
+        printf("%s is already loaded as another type of asset\n", asset_path);
+        return 0;
+    }
+    if (entry->refcount == 0 && is_entry_loaded(entry))
+    {
+        remove_from_lru(index);
+    }
+    entry->refcount++;
+    return index;
+}
+
+//another reference to an asset the caller already holds one of
+void retain_asset(asset_id id)
+{
+    asset_entry* entry = get_asset_entry(id);
+    assert(entry && entry->refcount > 0);
+    entry->refcount++;
+}
+
+void release_asset(asset_id id)
+{
+    if (!id)
+    {
+        return;
+    }
+    asset_entry* entry = get_asset_entry(id);
+    assert(entry->refcount > 0);
+    entry->refcount--;
+    if (entry->refcount == 0 && is_entry_loaded(entry))
+    {
+        add_to_lru(id);
+    }
+}
+
+asset_entry* get_asset_entry(asset_id id)
+{
+    if (id == 0 || id > num_assets)
+    {
+        return NULL;
+    }
+    return asset_entries + id;
+}
+
+const char* get_asset_key(asset_id id, uint32_t* out_length)
+{
+    asset_entry* entry = get_asset_entry(id);
+    *out_length = entry->key_length;
+    return (const char*)asset_path_arena->base + entry->key_offset;
+}
+
+void set_asset_data(asset_id id, void* data, uint32_t gpu_name)
 {
-    if(num_assets == MAX_NUM_ASSETS)
+    asset_entry* entry = get_asset_entry(id);
+    //only the owner sets it, while it holds a reference
+    assert(entry->refcount > 0);
+    SDL_LockMutex(asset_mutex);
+    entry->data     = data;
+    entry->gpu_name = gpu_name;
+    SDL_UnlockMutex(asset_mutex);
+}
+
+void* read_asset_data(asset_id id)
+{
+    asset_entry* entry = get_asset_entry(id);
+    if (!entry)
     {
-        return asset_tag{ASSET_TYPE_INVALID, 0, 0};
+        return NULL;
     }
+    SDL_LockMutex(asset_mutex);
+    void* data = entry->data;
+    SDL_UnlockMutex(asset_mutex);
+    return data;
+}
 
-    //first get the index of the path
-    uint32_t index = murmur3_32((const uint8_t*)asset_path, strlen(asset_path), SEED) % MAX_NUM_ASSETS;
-    index *= MAX_ASSET_PATH_LENGTH;
+void set_asset_size(asset_id id, uint64_t cpu_size, uint64_t gpu_size)
+{
+    asset_entry* entry = get_asset_entry(id);
+    cpu_resident = cpu_resident - entry->cpu_size + cpu_size;
+    gpu_resident = gpu_resident - entry->gpu_size + gpu_size;
+    entry->cpu_size = cpu_size;
+    entry->gpu_size = gpu_size;
+}
+
+bool is_asset_loaded(uint64_t hash)
+{
+    SDL_LockMutex(asset_mutex);
+    int32_t found = find_slot(hash, NULL, 0);
+    bool result = found >= 0 && is_entry_loaded(asset_entries + asset_slots[found].entry);
+    SDL_UnlockMutex(asset_mutex);
+    return result;
+}
+
+void set_asset_evict_function(asset_type type, asset_evict_function evict)
+{
+    evict_functions[type] = evict;
+}
 
-    while(asset_storage[index] != 0)
+void set_asset_budget(uint64_t new_cpu_budget, uint64_t new_gpu_budget)
+{
+    cpu_budget = new_cpu_budget;
+    gpu_budget = new_gpu_budget;
+}
+
+/*
+    Walks the LRU list from the oldest release on and only evicts what brings down a budget that is
+    exceeded. Evicting a model releases its textures, they go to the back of the list and only get
+    evicted in the same pass if that still isn't enough.
+*/
+void evict_unused_assets(void)
+{
+    uint32_t index = asset_entries[0].lru_next;
+    while (index && (cpu_resident > cpu_budget || gpu_resident > gpu_budget))
     {
-        if(strcmp(asset_storage + index, asset_path) == 0)
+        asset_entry* entry = asset_entries + index;
+        uint32_t next = entry->lru_next;
+
+        bool helps = (cpu_resident > cpu_budget && entry->cpu_size) ||
+                     (gpu_resident > gpu_budget && entry->gpu_size);
+        asset_evict_function evict = evict_functions[entry->type];
+        if (helps && evict && evict(entry))
         {
-            //same type and same index
-            return asset_tags[index/MAX_ASSET_PATH_LENGTH];
+            remove_from_lru(index);
+            set_asset_size(index, 0, 0);
+            SDL_LockMutex(asset_mutex);
+            entry->data     = NULL;
+            entry->gpu_name = 0;
+            SDL_UnlockMutex(asset_mutex);
         }
-        index = (index + MAX_ASSET_PATH_LENGTH) % MAX_NUM_ASSETS;
+        index = next;
     }
+}
 
-    //found the correct slot
-    strcpy(asset_storage + index, asset_path);
-    asset_tags[index/MAX_ASSET_PATH_LENGTH] = tag;
-    
-    return tag;
-}
\ No newline at end of file
+void print_asset_residency(void)
+{
+    uint32_t num_unused = 0;
+    for (uint32_t index = asset_entries[0].lru_next; index; index = asset_entries[index].lru_next)
+    {
+        num_unused++;
+    }
+    printf("Assets: %u known, %u unused, CPU %llu/%llu KB, GPU %llu/%llu KB\n", num_assets, num_unused,
+           (unsigned long long)(cpu_resident / Kilobytes(1)), (unsigned long long)(cpu_budget / Kilobytes(1)),
+           (unsigned long long)(gpu_resident / Kilobytes(1)), (unsigned long long)(gpu_budget / Kilobytes(1)));
+}
+
+uint32_t get_num_assets(void)
+{
+    return num_assets;
+}
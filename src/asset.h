@@ -1,8 +1,21 @@
 #ifndef ASSET_H
 #define ASSET_H
 
-#define MAX_NUM_ASSETS        1024
-#define MAX_ASSET_PATH_LENGTH 256
+#define MAX_ASSET_PATH_LENGTH    256
+#define ASSET_MEMORY_BUDGET      Megabytes(32)
+#define ASSET_PATH_MEMORY_BUDGET Megabytes(16)
+//power of two, the table doubles whenever it gets fuller than ASSET_TABLE_MAX_LOAD percent
+#define ASSET_TABLE_INITIAL_SIZE 1024
+#define ASSET_TABLE_MAX_LOAD     85
+//entries are never removed, an evicted asset keeps its entry and is loaded into it again
+#ifndef MAX_NUM_ASSETS
+#define MAX_NUM_ASSETS           16384
+#endif
+//what unreferenced assets may keep resident before the least recently used ones are evicted
+#define ASSET_CPU_BUDGET         Megabytes(256)
+#define ASSET_GPU_BUDGET         Megabytes(512)
+//keys of assets made from a source file together with something else are the path, this and the rest
+#define ASSET_KEY_SEPARATOR      '#'
 
 #include <string.h>
 
@@ -11,20 +24,59 @@
 
 typedef enum
 {
-    ASSET_TYPE_MESH,
+    ASSET_TYPE_MESH,      //a model, meshes and skeleton
     ASSET_TYPE_TEXTURE,
+    ASSET_TYPE_ANIMATION,
     ASSET_TYPE_INVALID,
     NUM_ASSET_TYPES
 }asset_type;
 
-struct asset_tag
+typedef uint32_t asset_id; //0 is no asset
+
+/*
+    Every user of an asset holds a reference. Once the last one is released the asset stays loaded
+    but goes on an LRU list, and evict_unused_assets unloads the oldest ones while the resident
+    memory is over budget. Acquiring it again before that takes it off the list.
+*/
+struct asset_entry
 {
+    uint64_t   hash;
+    void*      data;       //whatever the owner keeps the asset in, NULL if not loaded
+    uint64_t   cpu_size;
+    uint64_t   gpu_size;
+    uint32_t   gpu_name;   //GL object of assets that are just one, textures
+    uint32_t   refcount;
+    uint32_t   lru_prev;
+    uint32_t   lru_next;
+    uint32_t   key_offset; //into the path pool
+    uint32_t   key_length;
+    uint32_t   reload;     //asset_handle of the newest reload, not held, the next one waits for it
     asset_type type;
-    void*      data;
-    uint32_t   size;//size of the asset in bytes     
 };
 
-void      asset_storage_init();
-asset_tag find_asset_in_storage(const char* asset_path, asset_tag tag);
+//false if the asset can't go yet (still loading), it is tried again next time
+typedef bool(*asset_evict_function)(asset_entry* entry);
+
+void         asset_storage_init();
+uint64_t     asset_path_hash(const char* asset_path);
+//finds or adds the asset and takes a reference, 0 if the table is full
+asset_id     acquire_asset(const char* asset_path, asset_type type);
+void         retain_asset(asset_id id);
+void         release_asset(asset_id id);
+asset_entry* get_asset_entry(asset_id id);
+//not terminated, the path the asset was acquired with
+const char*  get_asset_key(asset_id id, uint32_t* out_length);
+void         set_asset_data(asset_id id, void* data, uint32_t gpu_name);
+//for job threads, the data is set on the main thread while they run
+void*        read_asset_data(asset_id id);
+void         set_asset_size(asset_id id, uint64_t cpu_size, uint64_t gpu_size);
+//hash only lookup for job threads that already have the hash of the path, no string compare
+bool         is_asset_loaded(uint64_t hash);
+void         set_asset_evict_function(asset_type type, asset_evict_function evict);
+void         set_asset_budget(uint64_t cpu_budget, uint64_t gpu_budget);
+//main thread, once a frame
+void         evict_unused_assets(void);
+void         print_asset_residency(void);
+uint32_t     get_num_assets(void);
 
 #endif
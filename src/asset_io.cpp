@@ -0,0 +1,497 @@
+#include "asset_io.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && !defined(ASSET_IO_NO_URING)
+#define ASSET_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+enum asset_io_stage
+{
+    ASSET_IO_OPEN,
+    ASSET_IO_READ,
+    ASSET_IO_CLOSE
+};
+
+static SDL_mutex*        io_mutex;
+static SDL_cond*         io_cond;
+//submitted but not flushed yet
+static asset_io_request* submitted_first;
+static asset_io_request* submitted_last;
+//flushed, waiting for a free submission entry (io_uring) or a free I/O thread
+static asset_io_request* ready_first;
+static asset_io_request* ready_last;
+static bool              use_uring;
+
+static void push_ready_front(asset_io_request* request)
+{
+    request->m_next = ready_first;
+    ready_first = request;
+    if (!ready_last)
+    {
+        ready_last = request;
+    }
+}
+
+static asset_io_request* pop_ready(void)
+{
+    asset_io_request* result = ready_first;
+    if (result)
+    {
+        ready_first = result->m_next;
+        if (!ready_first)
+        {
+            ready_last = NULL;
+        }
+    }
+    return result;
+}
+
+static uint8_t* allocate_io_data(asset_io_request* request, uint64_t size)
+{
+    if (request->m_arena)
+    {
+        return (uint8_t*)push_size(request->m_arena, size ? size : 1, CACHE_LINE_SIZE);
+    }
+    return (uint8_t*)malloc(size ? (size_t)size : 1);
+}
+
+static void fail_io(asset_io_request* request)
+{
+    printf("Failed to read %s\n", request->m_path);
+    free_asset_io_data(request);
+    request->m_data = NULL;
+    request->m_size = 0;
+}
+
+void free_asset_io_data(asset_io_request* request)
+{
+    if (!request->m_arena)
+    {
+        free(request->m_data);
+    }
+    request->m_data = NULL;
+}
+
+bool asset_file_exists(const char* path)
+{
+#ifdef _WIN32
+    return _access(path, 4) == 0;
+#else
+    return access(path, R_OK) == 0;
+#endif
+}
+
+void submit_asset_io(asset_io_request* request, const char* path, memory_arena* arena, asset_io_function done, void* arg)
+{
+    request->m_path   = path;
+    request->m_arena  = arena;
+    request->m_done   = done;
+    request->m_arg    = arg;
+    request->m_data   = NULL;
+    request->m_size   = 0;
+    request->m_next   = NULL;
+    request->m_offset = 0;
+    request->m_fd     = -1;
+    request->m_stage  = ASSET_IO_OPEN;
+
+    SDL_LockMutex(io_mutex);
+    if (submitted_last)
+    {
+        submitted_last->m_next = request;
+    }
+    else
+    {
+        submitted_first = request;
+    }
+    submitted_last = request;
+    SDL_UnlockMutex(io_mutex);
+}
+
+/*
+    Fallback, an I/O thread per read in flight. They are blocked on the disk instead of the job
+    threads.
+*/
+static void read_file_blocking(asset_io_request* request)
+{
+    FILE* file = fopen(request->m_path, "rb");
+    if (!file)
+    {
+        fail_io(request);
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    request->m_size = size > 0 ? (uint64_t)size : 0;
+    request->m_data = size >= 0 ? allocate_io_data(request, request->m_size) : NULL;
+    if (!request->m_data || fread(request->m_data, 1, (size_t)request->m_size, file) != (size_t)request->m_size)
+    {
+        fail_io(request);
+    }
+    fclose(file);
+}
+
+static int io_thread(void* arg)
+{
+    for (;;)
+    {
+        SDL_LockMutex(io_mutex);
+        asset_io_request* request;
+        while ((request = pop_ready()) == NULL)
+        {
+            SDL_CondWait(io_cond, io_mutex);
+        }
+        SDL_UnlockMutex(io_mutex);
+
+        read_file_blocking(request);
+        request->m_done(request);
+    }
+    return 0;
+}
+
+#ifdef ASSET_IO_URING
+
+/*
+    The rings are shared with the kernel: we write submission entries and move the submission tail,
+    the kernel moves the completion tail. Everything submitting holds io_mutex, only the reaper
+    thread consumes completions. No more operations are in flight than the completion ring holds,
+    so it never overflows.
+*/
+struct io_ring
+{
+    int32_t        fd;
+    uint32_t*      sq_head;
+    uint32_t*      sq_tail;
+    uint32_t*      sq_array;
+    uint32_t       sq_mask;
+    uint32_t       sq_entries;
+    io_uring_sqe*  sqes;
+    uint32_t*      cq_head;
+    uint32_t*      cq_tail;
+    io_uring_cqe*  cqes;
+    uint32_t       cq_mask;
+    uint32_t       cq_entries;
+    uint32_t       in_flight;
+};
+
+static io_ring ring;
+
+static int32_t io_uring_enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags)
+{
+    return (int32_t)syscall(__NR_io_uring_enter, ring.fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+//the ring itself came in earlier kernels than opening, reading and closing through it
+static bool ring_supports_file_ops(int32_t fd)
+{
+    uint64_t buffer[(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op)) / sizeof(uint64_t) + 1];
+    memset(buffer, 0, sizeof(buffer));
+    io_uring_probe* probe = (io_uring_probe*)buffer;
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+    {
+        return false;
+    }
+    uint8_t ops[] = { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE };
+    for (uint32_t i = 0; i < sizeof(ops); ++i)
+    {
+        if (ops[i] > probe->last_op || !(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool setup_ring(void)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int32_t fd = (int32_t)syscall(__NR_io_uring_setup, ASSET_IO_QUEUE_DEPTH, &params);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (!ring_supports_file_ops(fd))
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap)
+    {
+        sq_size = cq_size = sq_size > cq_size ? sq_size : cq_size;
+    }
+
+    uint8_t* sq = (uint8_t*)mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    uint8_t* cq = single_mmap ? sq : (uint8_t*)mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    void* sqes  = mmap(NULL, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        //the process is about to fall back for good, what did get mapped can stay
+        close(fd);
+        return false;
+    }
+
+    ring.fd         = fd;
+    ring.sq_head    = (uint32_t*)(sq + params.sq_off.head);
+    ring.sq_tail    = (uint32_t*)(sq + params.sq_off.tail);
+    ring.sq_array   = (uint32_t*)(sq + params.sq_off.array);
+    ring.sq_mask    = *(uint32_t*)(sq + params.sq_off.ring_mask);
+    ring.sq_entries = params.sq_entries;
+    ring.sqes       = (io_uring_sqe*)sqes;
+    ring.cq_head    = (uint32_t*)(cq + params.cq_off.head);
+    ring.cq_tail    = (uint32_t*)(cq + params.cq_off.tail);
+    ring.cqes       = (io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring.cq_mask    = *(uint32_t*)(cq + params.cq_off.ring_mask);
+    ring.cq_entries = params.cq_entries;
+    ring.in_flight  = 0;
+    return true;
+}
+
+//io_mutex held. False if the rings are full, the request stays where it is
+static bool push_submission(asset_io_request* request)
+{
+    uint32_t tail = *ring.sq_tail;
+    uint32_t head = __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head == ring.sq_entries || ring.in_flight == ring.cq_entries)
+    {
+        return false;
+    }
+
+    uint32_t index = tail & ring.sq_mask;
+    io_uring_sqe* sqe = ring.sqes + index;
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    switch (request->m_stage)
+    {
+        case ASSET_IO_OPEN:
+        {
+            sqe->opcode     = IORING_OP_OPENAT;
+            sqe->fd         = AT_FDCWD;
+            sqe->addr       = (uint64_t)(uintptr_t)request->m_path;
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        }break;
+        case ASSET_IO_READ:
+        {
+            uint64_t left   = request->m_size - request->m_offset;
+            sqe->opcode     = IORING_OP_READ;
+            sqe->fd         = request->m_fd;
+            sqe->addr       = (uint64_t)(uintptr_t)(request->m_data + request->m_offset);
+            sqe->len        = (uint32_t)(left < ASSET_IO_MAX_READ ? left : ASSET_IO_MAX_READ);
+            sqe->off        = request->m_offset;
+        }break;
+        case ASSET_IO_CLOSE:
+        {
+            sqe->opcode     = IORING_OP_CLOSE;
+            sqe->fd         = request->m_fd;
+        }break;
+    }
+    sqe->user_data = (uint64_t)(uintptr_t)request;
+    ring.sq_array[index] = index;
+    __atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring.in_flight++;
+    return true;
+}
+
+//io_mutex held, returns how many went in
+static uint32_t push_ready_submissions(void)
+{
+    uint32_t result = 0;
+    while (ready_first && push_submission(ready_first))
+    {
+        pop_ready();
+        result++;
+    }
+    return result;
+}
+
+//what comes after an operation finished, false once the request is done
+static bool advance_request(asset_io_request* request, int32_t result)
+{
+    switch (request->m_stage)
+    {
+        case ASSET_IO_OPEN:
+        {
+            if (result < 0)
+            {
+                fail_io(request);
+                return false;
+            }
+            //the open brought the inode in, this doesn't wait on the disk
+            struct stat st;
+            request->m_fd = result;
+            request->m_data = fstat(result, &st) == 0 ? allocate_io_data(request, (uint64_t)st.st_size) : NULL;
+            request->m_size = request->m_data ? (uint64_t)st.st_size : 0;
+            if (!request->m_data)
+            {
+                fail_io(request);
+                request->m_stage = ASSET_IO_CLOSE;
+            }
+            else
+            {
+                request->m_stage = request->m_size ? ASSET_IO_READ : ASSET_IO_CLOSE;
+            }
+        }break;
+        case ASSET_IO_READ:
+        {
+            if (result <= 0)
+            {
+                fail_io(request);
+                request->m_stage = ASSET_IO_CLOSE;
+                break;
+            }
+            request->m_offset += (uint64_t)result;
+            if (request->m_offset == request->m_size)
+            {
+                request->m_stage = ASSET_IO_CLOSE;
+            }
+        }break;
+        case ASSET_IO_CLOSE:
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int reap_thread(void* arg)
+{
+    for (;;)
+    {
+        if (io_uring_enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+        {
+            printf("Waiting on io_uring failed: %s\n", strerror(errno));
+            return 1;
+        }
+
+        //follow up operations go before new files, what is half read gets done first
+        asset_io_request* done = NULL;
+        asset_io_request* next = NULL;
+        uint32_t num_reaped = 0;
+        uint32_t head = *ring.cq_head;
+        uint32_t tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head, ++num_reaped)
+        {
+            io_uring_cqe* cqe = ring.cqes + (head & ring.cq_mask);
+            asset_io_request* request = (asset_io_request*)(uintptr_t)cqe->user_data;
+            if (advance_request(request, cqe->res))
+            {
+                request->m_next = next;
+                next = request;
+            }
+            else
+            {
+                request->m_next = done;
+                done = request;
+            }
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+        SDL_LockMutex(io_mutex);
+        ring.in_flight -= num_reaped;
+        while (next)
+        {
+            asset_io_request* request = next;
+            next = next->m_next;
+            push_ready_front(request);
+        }
+        uint32_t to_submit = push_ready_submissions();
+        SDL_UnlockMutex(io_mutex);
+        if (to_submit)
+        {
+            io_uring_enter(to_submit, 0, 0);
+        }
+
+        while (done)
+        {
+            asset_io_request* request = done;
+            done = done->m_next;
+            request->m_done(request);
+        }
+    }
+    return 0;
+}
+
+#endif
+
+void flush_asset_io(void)
+{
+    SDL_LockMutex(io_mutex);
+    if (!submitted_first)
+    {
+        SDL_UnlockMutex(io_mutex);
+        return;
+    }
+    if (ready_last)
+    {
+        ready_last->m_next = submitted_first;
+    }
+    else
+    {
+        ready_first = submitted_first;
+    }
+    ready_last      = submitted_last;
+    submitted_first = NULL;
+    submitted_last  = NULL;
+
+#ifdef ASSET_IO_URING
+    if (use_uring)
+    {
+        //one system call for the whole batch
+        uint32_t to_submit = push_ready_submissions();
+        SDL_UnlockMutex(io_mutex);
+        if (to_submit)
+        {
+            io_uring_enter(to_submit, 0, 0);
+        }
+        return;
+    }
+#endif
+    SDL_UnlockMutex(io_mutex);
+    SDL_CondBroadcast(io_cond);
+}
+
+void asset_io_init(void)
+{
+    io_mutex = SDL_CreateMutex();
+    io_cond  = SDL_CreateCond();
+    use_uring = false;
+
+#ifdef ASSET_IO_URING
+    if (setup_ring() && SDL_CreateThread(&reap_thread, "Asset I/O", NULL))
+    {
+        use_uring = true;
+        printf("Asset reads go through io_uring, %u entries\n", ring.sq_entries);
+        return;
+    }
+    printf("io_uring is not available, asset reads go through %u I/O threads\n", NUM_ASSET_IO_THREADS);
+#endif
+
+    for (uint32_t i = 0; i < NUM_ASSET_IO_THREADS; ++i)
+    {
+        if (!SDL_CreateThread(&io_thread, "Asset I/O", NULL))
+        {
+            printf("Failed to create an asset I/O thread\n");
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef ASSET_IO_H
+#define ASSET_IO_H
+
+#include <stdint.h>
+
+#include "memory.h"
+
+/*
+    Whole file reads that don't keep a job thread waiting on the disk. Requests are queued from any
+    thread and handed over together by flush_asset_io. The done function runs on an I/O thread once
+    the file is in memory, or couldn't be read, and should only pass the bytes on.
+
+    On Linux the reads go through io_uring: the open, the reads and the close are all asynchronous,
+    one I/O thread reaps the completions and queues what comes next. Without io_uring (other
+    platforms, old kernels, sandboxes that forbid it, or built with ASSET_IO_NO_URING)
+    NUM_ASSET_IO_THREADS threads read the files with blocking calls instead.
+*/
+#define ASSET_IO_QUEUE_DEPTH 64
+#define NUM_ASSET_IO_THREADS 2
+//one read is at most this much, bigger files take several
+#define ASSET_IO_MAX_READ    Megabytes(64)
+
+struct asset_io_request;
+typedef void(*asset_io_function)(asset_io_request* request);
+
+struct asset_io_request
+{
+    const char*       m_path;  //has to stay alive until it is done
+    memory_arena*     m_arena; //where the bytes go, nobody else may push to it until done. malloced if NULL
+    asset_io_function m_done;
+    void*             m_arg;
+    uint8_t*          m_data;  //NULL if the file couldn't be read
+    uint64_t          m_size;
+    //only the I/O layer touches these
+    asset_io_request* m_next;
+    uint64_t          m_offset;
+    int32_t           m_fd;
+    uint32_t          m_stage;
+};
+
+void asset_io_init(void);
+void submit_asset_io(asset_io_request* request, const char* path, memory_arena* arena, asset_io_function done, void* arg);
+//hands everything submitted so far over in one go
+void flush_asset_io(void);
+//only for malloced ones, arena memory goes with its arena
+void free_asset_io_data(asset_io_request* request);
+bool asset_file_exists(const char* path);
+
+#endif
@@ -0,0 +1,367 @@
+#include "asset_stream.h"
+
+#include <stdio.h>
+#include <cassert>
+#include <SDL.h>
+
+#include "thread.h"
+
+static asset_load  asset_loads[MAX_NUM_ASSET_LOADS];
+static asset_load* free_asset_loads;
+static uint32_t    num_pending_loads;
+//loads waiting for their dependency, only the main thread touches these
+static asset_load* waiting_loads[MAX_NUM_ASSET_LOADS];
+static uint32_t    num_waiting_loads;
+//ring of the loads the job threads are done with, in the order they finished. Every load goes in once
+static SDL_mutex*  finished_mutex;
+static asset_load* finished_loads[MAX_NUM_ASSET_LOADS];
+static uint32_t    finished_read;
+static uint32_t    finished_write;
+//load in the middle of its upload steps, carries over to the next frame
+static asset_load* uploading_load;
+
+//the low 16 bits are the slot + 1, the high ones its generation
+static inline asset_handle get_asset_handle(asset_load* load)
+{
+    return (load->m_generation << 16) | (uint32_t)(load - asset_loads + 1);
+}
+
+//NULL for 0, ASSET_LOAD_FAILED and handles whose slot went back, a released load is there until it is done
+static asset_load* get_asset_load(asset_handle handle)
+{
+    uint32_t index = (handle & 0xFFFF) - 1;
+    if (handle == 0 || index >= MAX_NUM_ASSET_LOADS)
+    {
+        return NULL;
+    }
+    asset_load* load = asset_loads + index;
+    return load->m_generation == (handle >> 16) ? load : NULL;
+}
+
+//the slot goes back once nobody holds it and it is done
+static void free_asset_load_if_unused(asset_load* load)
+{
+    if (load->m_refs || !load->m_finished)
+    {
+        return;
+    }
+    load->m_generation = (load->m_generation + 1) & 0xFFFF;
+    load->m_next_free  = free_asset_loads;
+    free_asset_loads   = load;
+}
+
+static void unref_asset_load(asset_load* load)
+{
+    assert(load->m_refs);
+    load->m_refs--;
+    free_asset_load_if_unused(load);
+}
+
+static double get_elapsed_ms(uint64_t start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+//whichever job of the load finishes last hands it over to the main thread
+static void finish_asset_job(asset_load* load)
+{
+    if (load->m_num_jobs.fetch_sub(1) != 1)
+    {
+        return;
+    }
+    if (load->m_state != ASSET_STATE_FAILED)
+    {
+        load->m_state = ASSET_STATE_UPLOADING;
+    }
+
+    SDL_LockMutex(finished_mutex);
+    finished_loads[finished_write++ & (MAX_NUM_ASSET_LOADS - 1)] = load;
+    SDL_UnlockMutex(finished_mutex);
+}
+
+void fail_asset_load(asset_load* load)
+{
+    load->m_state = ASSET_STATE_FAILED;
+}
+
+//the reads a job submitted go to the disk together once it is done
+static void asset_load_job(void* arg)
+{
+    asset_load* load = (asset_load*)arg;
+    if (!load->m_load(load))
+    {
+        fail_asset_load(load);
+    }
+    flush_asset_io();
+    finish_asset_job(load);
+}
+
+static void asset_subjob_job(void* arg)
+{
+    asset_subjob* job = (asset_subjob*)arg;
+    job->m_function(job);
+    flush_asset_io();
+    finish_asset_job(job->m_load);
+}
+
+void submit_asset_subjob(asset_load* load, asset_subjob* job, asset_subjob_function function)
+{
+    //the load's own job is still running, so the count can't reach 0 before this one is added
+    job->m_load     = load;
+    job->m_function = function;
+    load->m_num_jobs++;
+
+    thread_job subjob = { &asset_subjob_job, job, NULL };
+    submit_job(subjob);
+}
+
+//I/O thread, the subjob was counted when the read was submitted
+//runs on an I/O thread, which has more reads to finish than to parse this one itself
+static void asset_read_done(asset_io_request* request)
+{
+    thread_job job = { &asset_subjob_job, request->m_arg, NULL };
+    submit_job_blocking(job);
+}
+
+void submit_asset_read(asset_load* load, asset_read_job* job, const char* path, memory_arena* arena,
+                       asset_subjob_function function)
+{
+    job->m_job.m_load     = load;
+    job->m_job.m_function = function;
+    load->m_num_jobs++;
+    submit_asset_io(&job->m_file, path, arena, &asset_read_done, &job->m_job);
+}
+
+static void start_asset_load(asset_load* load)
+{
+    load->m_num_jobs = 1;
+    load->m_state = ASSET_STATE_LOADING;
+    if (!load->m_load)
+    {
+        //nothing to run on a job thread, straight to the upload steps
+        finish_asset_job(load);
+        return;
+    }
+    thread_job job = { &asset_load_job, load, NULL };
+    submit_job(job);
+}
+
+static void finish_asset_load(asset_load* load, asset_state state)
+{
+    load->m_state    = state;
+    load->m_finished = true;
+    num_pending_loads--;
+    if (state == ASSET_STATE_READY)
+    {
+        printf("Streamed %s in %.3f ms\n", load->m_path, get_elapsed_ms(load->m_start));
+    }
+    else
+    {
+        printf("Failed to stream %s\n", load->m_path);
+    }
+
+    //the last one to hold a dependency may free it, and this one may be released already
+    for (uint32_t i = 0; i < MAX_ASSET_LOAD_DEPENDENCIES; ++i)
+    {
+        asset_load* dependency = get_asset_load(load->m_depends_on[i]);
+        if (dependency)
+        {
+            unref_asset_load(dependency);
+        }
+        load->m_depends_on[i] = 0;
+    }
+    free_asset_load_if_unused(load);
+}
+
+void asset_stream_init(void)
+{
+    finished_mutex    = SDL_CreateMutex();
+    free_asset_loads  = NULL;
+    for (uint32_t i = MAX_NUM_ASSET_LOADS; i > 0; --i)
+    {
+        asset_load* load = asset_loads + i - 1;
+        load->m_generation = 1;
+        load->m_refs       = 0;
+        load->m_next_free  = free_asset_loads;
+        free_asset_loads   = load;
+    }
+    num_pending_loads = 0;
+    num_waiting_loads = 0;
+    finished_read     = 0;
+    finished_write    = 0;
+    uploading_load    = NULL;
+    asset_io_init();
+}
+
+//failed if any of them failed, ready once all of them are
+static asset_state get_dependency_state(asset_load* load)
+{
+    asset_state result = ASSET_STATE_READY;
+    for (uint32_t i = 0; i < MAX_ASSET_LOAD_DEPENDENCIES; ++i)
+    {
+        //one that was released and reused was done long ago
+        asset_state state = get_asset_state(load->m_depends_on[i]);
+        if (state == ASSET_STATE_FAILED)
+        {
+            return ASSET_STATE_FAILED;
+        }
+        if (state != ASSET_STATE_NONE && state != ASSET_STATE_READY)
+        {
+            result = ASSET_STATE_WAITING;
+        }
+    }
+    return result;
+}
+
+asset_handle begin_asset_load(const char* path, asset_load_function load_function, asset_upload_function upload,
+                              void* target, uint32_t param, asset_handle depends_on, asset_handle also_depends_on)
+{
+    if (!free_asset_loads)
+    {
+        printf("Too many asset loads, can not load %s\n", path);
+        return ASSET_LOAD_FAILED;
+    }
+
+    asset_load* load = free_asset_loads;
+    free_asset_loads = load->m_next_free;
+    asset_handle handle = get_asset_handle(load);
+    snprintf(load->m_path, sizeof(load->m_path), "%s", path);
+    load->m_load          = load_function;
+    load->m_upload        = upload;
+    load->m_target        = target;
+    load->m_result        = NULL;
+    load->m_param         = param;
+    load->m_upload_step   = 0;
+    load->m_depends_on[0] = depends_on;
+    load->m_depends_on[1] = also_depends_on;
+    load->m_start         = SDL_GetPerformanceCounter();
+    load->m_refs          = 1;
+    load->m_finished      = false;
+    load->m_next_free     = NULL;
+    num_pending_loads++;
+    for (uint32_t i = 0; i < MAX_ASSET_LOAD_DEPENDENCIES; ++i)
+    {
+        asset_load* dependency = get_asset_load(load->m_depends_on[i]);
+        if (dependency)
+        {
+            dependency->m_refs++;
+        }
+    }
+
+    asset_state dependency = get_dependency_state(load);
+    if (dependency == ASSET_STATE_FAILED)
+    {
+        finish_asset_load(load, ASSET_STATE_FAILED);
+    }
+    else if (dependency != ASSET_STATE_READY)
+    {
+        load->m_state = ASSET_STATE_WAITING;
+        waiting_loads[num_waiting_loads++] = load;
+    }
+    else
+    {
+        start_asset_load(load);
+    }
+    return handle;
+}
+
+void release_asset_load(asset_handle handle)
+{
+    asset_load* load = get_asset_load(handle);
+    if (load)
+    {
+        unref_asset_load(load);
+    }
+}
+
+asset_state get_asset_state(asset_handle handle)
+{
+    if (handle == ASSET_LOAD_FAILED)
+    {
+        return ASSET_STATE_FAILED;
+    }
+    asset_load* load = get_asset_load(handle);
+    return load ? (asset_state)load->m_state.load() : ASSET_STATE_NONE;
+}
+
+bool is_asset_ready(asset_handle handle)
+{
+    return handle == 0 || get_asset_state(handle) == ASSET_STATE_READY;
+}
+
+//starts the loads whose dependencies got ready, fails the ones with a dependency that failed
+static void start_waiting_loads(void)
+{
+    uint32_t num_still_waiting = 0;
+    for (uint32_t i = 0; i < num_waiting_loads; ++i)
+    {
+        asset_load* load = waiting_loads[i];
+        asset_state dependency = get_dependency_state(load);
+        if (dependency == ASSET_STATE_READY)
+        {
+            start_asset_load(load);
+        }
+        else if (dependency == ASSET_STATE_FAILED)
+        {
+            finish_asset_load(load, ASSET_STATE_FAILED);
+        }
+        else
+        {
+            waiting_loads[num_still_waiting++] = waiting_loads[i];
+        }
+    }
+    num_waiting_loads = num_still_waiting;
+}
+
+static asset_load* pop_finished_load(void)
+{
+    asset_load* result = NULL;
+    SDL_LockMutex(finished_mutex);
+    if (finished_read != finished_write)
+    {
+        result = finished_loads[finished_read++ & (MAX_NUM_ASSET_LOADS - 1)];
+    }
+    SDL_UnlockMutex(finished_mutex);
+    return result;
+}
+
+void process_asset_loads(float budget_ms)
+{
+    uint64_t start = SDL_GetPerformanceCounter();
+
+    //always at least one step, a step bigger than the whole budget still gets through
+    do
+    {
+        if (!uploading_load)
+        {
+            uploading_load = pop_finished_load();
+            if (!uploading_load)
+            {
+                break;
+            }
+        }
+
+        asset_load* load = uploading_load;
+        if (load->m_state == ASSET_STATE_FAILED)
+        {
+            uploading_load = NULL;
+            finish_asset_load(load, ASSET_STATE_FAILED);
+        }
+        else if (!load->m_upload || load->m_upload(load))
+        {
+            uploading_load = NULL;
+            finish_asset_load(load, ASSET_STATE_READY);
+        }
+        else
+        {
+            load->m_upload_step++;
+        }
+    } while (get_elapsed_ms(start) < budget_ms);
+
+    start_waiting_loads();
+}
+
+uint32_t get_num_pending_assets(void)
+{
+    return num_pending_loads;
+}
@@ -0,0 +1,109 @@
+#ifndef ASSET_STREAM_H
+#define ASSET_STREAM_H
+
+#include <stdint.h>
+#include <atomic>
+
+#include "asset.h"
+#include "asset_io.h"
+
+//loads in flight or still held by somebody, a power of two
+#define MAX_NUM_ASSET_LOADS    1024
+//main thread time spent on uploads at the start of every frame
+#define ASSET_UPLOAD_BUDGET_MS 2.0f
+
+/*
+    Every load runs in two halves. The load function parses and decodes on a job thread, into that
+    thread's arena. The upload function runs on the main thread, which owns the GL context, one step
+    per call until it returns true, for as long as the frame's upload budget lasts.
+
+    A load can depend on up to two earlier ones (an animation on the model that brings the skeleton),
+    it is only handed to the job threads once they are ready. A load with no load function only waits
+    for them and then runs its upload steps. The load function can split its work into
+    subjobs (one per texture to decode), the upload only starts once all of them are done. A subjob
+    can wait for a file instead (see asset_io.h), it only goes to a job thread once the file is read,
+    so no job thread sits waiting on the disk.
+*/
+/*
+    begin_asset_load hands out a reference with the handle, the slot goes back once it is released
+    and the load is done. A load holds its dependencies until it is done itself. Handles carry the
+    slot's generation, so one that was released reads as ASSET_STATE_NONE after the slot is reused.
+    Until then it still reports the load's state, a later load can be made to wait for it.
+    ASSET_LOAD_FAILED is handed out when every slot is taken, it always reads as failed.
+*/
+typedef uint32_t asset_handle; //0 is no load at all, which counts as ready
+#define ASSET_LOAD_FAILED 0xFFFFu
+
+enum asset_state
+{
+    ASSET_STATE_NONE,
+    ASSET_STATE_WAITING,   //for the load it depends on
+    ASSET_STATE_LOADING,   //queued or running on a job thread
+    ASSET_STATE_UPLOADING, //queued for or in the middle of its main thread steps
+    ASSET_STATE_READY,
+    ASSET_STATE_FAILED
+};
+
+struct asset_load;
+//job thread, false if the asset can't be loaded
+typedef bool(*asset_load_function)(asset_load* load);
+//main thread, true once there is nothing left to upload
+typedef bool(*asset_upload_function)(asset_load* load);
+
+struct asset_subjob;
+typedef void(*asset_subjob_function)(asset_subjob* job);
+
+#define MAX_ASSET_LOAD_DEPENDENCIES 2
+
+//has to stay alive until it has run, usually lives in the job thread's arena with the load's data
+struct asset_subjob
+{
+    asset_load*           m_load;
+    asset_subjob_function m_function;
+};
+
+//a subjob with the file it runs on
+struct asset_read_job
+{
+    asset_subjob     m_job;  //first, the subjob function gets the read back from it
+    asset_io_request m_file;
+};
+
+struct asset_load
+{
+    char                  m_path[MAX_ASSET_PATH_LENGTH];
+    asset_load_function   m_load;        //NULL if there is nothing to do on a job thread
+    asset_upload_function m_upload;      //NULL if there is nothing to do on the main thread
+    void*                 m_target;      //what is loaded into
+    void*                 m_result;      //handed from the load to the upload function
+    uint32_t              m_param;
+    uint32_t              m_upload_step;
+    asset_handle          m_depends_on[MAX_ASSET_LOAD_DEPENDENCIES];
+    uint64_t              m_start;
+    uint32_t              m_generation;  //of the handle it was begun with
+    uint32_t              m_refs;        //main thread only, like everything below
+    bool                  m_finished;
+    asset_load*           m_next_free;
+    std::atomic<uint32_t> m_state;
+    std::atomic<uint32_t> m_num_jobs;    //the load itself and its subjobs still running
+};
+
+void         asset_stream_init(void);
+asset_handle begin_asset_load(const char* path, asset_load_function load, asset_upload_function upload,
+                              void* target, uint32_t param, asset_handle depends_on, asset_handle also_depends_on = 0);
+//main thread only, like begin_asset_load
+void         release_asset_load(asset_handle handle);
+asset_state  get_asset_state(asset_handle handle);
+bool         is_asset_ready(asset_handle handle);
+//only from inside the load's own load function or subjobs
+void         submit_asset_subjob(asset_load* load, asset_subjob* job, asset_subjob_function function);
+//the function runs once the whole file is in job->m_file, which has m_data NULL if it couldn't be read
+void         submit_asset_read(asset_load* load, asset_read_job* job, const char* path, memory_arena* arena,
+                               asset_subjob_function function);
+//from the load's own functions, the load fails once all its jobs are done
+void         fail_asset_load(asset_load* load);
+//uploads finished loads and starts the ones whose dependency got ready, main thread only
+void         process_asset_loads(float budget_ms);
+uint32_t     get_num_pending_assets(void);
+
+#endif
@@ -0,0 +1,196 @@
+#include "asset_watch.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#include "asset.h"
+
+struct watched_directory
+{
+    int32_t wd;
+    char    path[MAX_ASSET_PATH_LENGTH];
+};
+
+struct pending_change
+{
+    char     path[MAX_ASSET_PATH_LENGTH];
+    uint32_t last_write; //SDL_GetTicks of the newest event for it
+};
+
+static int32_t           watch_fd = -1;
+static watched_directory watched_directories[MAX_WATCHED_DIRECTORIES];
+static uint32_t          num_watched_directories;
+static pending_change    pending_changes[MAX_PENDING_ASSET_CHANGES];
+static uint32_t          num_pending_changes;
+
+#ifdef __linux__
+
+#define ASSET_WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)
+
+//the directory and everything below it
+static void watch_directory(const char* path)
+{
+    if (num_watched_directories == MAX_WATCHED_DIRECTORIES)
+    {
+        printf("Too many asset directories, not watching %s\n", path);
+        return;
+    }
+    int32_t wd = inotify_add_watch(watch_fd, path, ASSET_WATCH_EVENTS | IN_ONLYDIR);
+    if (wd < 0)
+    {
+        printf("Can not watch %s: %s\n", path, strerror(errno));
+        return;
+    }
+    watched_directory* directory = watched_directories + num_watched_directories++;
+    directory->wd = wd;
+    snprintf(directory->path, sizeof(directory->path), "%s", path);
+
+    DIR* dir = opendir(path);
+    if (!dir)
+    {
+        return;
+    }
+    struct dirent* item;
+    while ((item = readdir(dir)) != NULL)
+    {
+        if (item->d_type != DT_DIR || strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0)
+        {
+            continue;
+        }
+        char child[MAX_ASSET_PATH_LENGTH];
+        snprintf(child, sizeof(child), "%s/%s", path, item->d_name);
+        watch_directory(child);
+    }
+    closedir(dir);
+}
+
+static watched_directory* find_watched_directory(int32_t wd)
+{
+    for (uint32_t i = 0; i < num_watched_directories; ++i)
+    {
+        if (watched_directories[i].wd == wd)
+        {
+            return watched_directories + i;
+        }
+    }
+    return NULL;
+}
+
+//another write to a file that is already pending only pushes its settle time out
+static void add_pending_change(const char* path, uint32_t now)
+{
+    for (uint32_t i = 0; i < num_pending_changes; ++i)
+    {
+        if (strcmp(pending_changes[i].path, path) == 0)
+        {
+            pending_changes[i].last_write = now;
+            return;
+        }
+    }
+    if (num_pending_changes == MAX_PENDING_ASSET_CHANGES)
+    {
+        printf("Too many changed assets, not reloading %s\n", path);
+        return;
+    }
+    pending_change* change = pending_changes + num_pending_changes++;
+    snprintf(change->path, sizeof(change->path), "%s", path);
+    change->last_write = now;
+}
+
+static void read_watch_events(uint32_t now)
+{
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t size = read(watch_fd, buffer, sizeof(buffer));
+        if (size <= 0)
+        {
+            //EAGAIN, nothing more happened since the last frame
+            return;
+        }
+        for (char* at = buffer; at < buffer + size; at += sizeof(struct inotify_event) + ((struct inotify_event*)at)->len)
+        {
+            struct inotify_event* event = (struct inotify_event*)at;
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                printf("Asset watch events were dropped, some changes are not reloaded\n");
+                continue;
+            }
+            watched_directory* directory = find_watched_directory(event->wd);
+            if (!directory || event->len == 0)
+            {
+                continue;
+            }
+
+            char path[MAX_ASSET_PATH_LENGTH];
+            snprintf(path, sizeof(path), "%s/%s", directory->path, event->name);
+            if (event->mask & IN_ISDIR)
+            {
+                watch_directory(path);
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+            {
+                add_pending_change(path, now);
+            }
+        }
+    }
+}
+
+bool asset_watch_init(const char* root_directory)
+{
+    watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch_fd < 0)
+    {
+        printf("Can not watch the assets for changes: %s\n", strerror(errno));
+        return false;
+    }
+    watch_directory(root_directory);
+    printf("Watching %u asset directories for changes\n", num_watched_directories);
+    return num_watched_directories > 0;
+}
+
+#else
+
+bool asset_watch_init(const char* root_directory)
+{
+    (void)root_directory;
+    return false;
+}
+
+static void read_watch_events(uint32_t now)
+{
+    (void)now;
+}
+
+#endif
+
+bool poll_asset_change(char* out_path, uint32_t out_size)
+{
+    if (watch_fd < 0)
+    {
+        return false;
+    }
+    uint32_t now = SDL_GetTicks();
+    read_watch_events(now);
+
+    for (uint32_t i = 0; i < num_pending_changes; ++i)
+    {
+        pending_change* change = pending_changes + i;
+        if (now - change->last_write >= ASSET_WATCH_SETTLE_MS)
+        {
+            snprintf(out_path, out_size, "%s", change->path);
+            *change = pending_changes[--num_pending_changes];
+            return true;
+        }
+    }
+    return false;
+}
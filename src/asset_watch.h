@@ -0,0 +1,20 @@
+#ifndef ASSET_WATCH_H
+#define ASSET_WATCH_H
+
+#include <stdint.h>
+
+/*
+    Watches the asset directories, and every directory made in them later, for files that were
+    written or moved in. Editors and exporters often write a file in several goes, so a change is
+    only handed out once the file was left alone for ASSET_WATCH_SETTLE_MS. Uses inotify, on other
+    platforms nothing is ever reported and assets only change with a restart.
+*/
+#define MAX_WATCHED_DIRECTORIES   256
+#define MAX_PENDING_ASSET_CHANGES 64
+#define ASSET_WATCH_SETTLE_MS     200
+
+bool asset_watch_init(const char* root_directory);
+//main thread, once a frame. Hands out one settled change per call, false once there are none
+bool poll_asset_change(char* out_path, uint32_t out_size);
+
+#endif
@@ -0,0 +1,622 @@
+#include "baked_asset.h"
+
+#include <stdio.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "entity.h"
+#include "character.h"
+
+static inline uint64_t align_baked_offset(uint64_t offset)
+{
+    return (offset + BAKED_ASSET_ALIGNMENT - 1) & ~(uint64_t)(BAKED_ASSET_ALIGNMENT - 1);
+}
+
+void get_baked_path(const char* source_path, const char* extension, char* out_buffer, uint32_t out_size)
+{
+    //swap the extension, if there is one after the last slash
+    const char* dot = strrchr(source_path, '.');
+    const char* slash = strrchr(source_path, '/');
+    size_t length = (dot && (!slash || dot > slash)) ? (size_t)(dot - source_path) : strlen(source_path);
+    snprintf(out_buffer, out_size, "%.*s%s", (int)length, source_path, extension);
+}
+
+void get_baked_asset_path(const char* source_path, char* out_buffer, uint32_t out_size)
+{
+    get_baked_path(source_path, BAKED_ASSET_EXTENSION, out_buffer, out_size);
+}
+
+/*
+    Writing takes two passes over the same order of blocks: the first one only works out where every
+    block goes and fills in the (small) tables, the second streams the blocks to the file with zero
+    padding in between. Vertex and index arrays go out straight from the mesh.
+*/
+struct baked_writer
+{
+    FILE*    file;
+    uint64_t offset;
+    bool     ok;
+};
+
+static uint64_t reserve_baked_block(uint64_t* cursor, uint64_t size)
+{
+    uint64_t result = align_baked_offset(*cursor);
+    *cursor = result + size;
+    return result;
+}
+
+static void write_baked_block(baked_writer* writer, uint64_t at, const void* data, uint64_t size)
+{
+    static const uint8_t zeroes[BAKED_ASSET_ALIGNMENT] = {};
+    assert(at >= writer->offset && at - writer->offset < BAKED_ASSET_ALIGNMENT);
+    uint64_t padding = at - writer->offset;
+    if (padding && fwrite(zeroes, 1, padding, writer->file) != padding)
+    {
+        writer->ok = false;
+    }
+    if (size && fwrite(data, 1, size, writer->file) != size)
+    {
+        writer->ok = false;
+    }
+    writer->offset = at + size;
+}
+
+//key structs have padding, they are copied field by field so it goes out as zeroes
+template<typename T>
+static void write_baked_keys(baked_writer* writer, uint64_t at, T* keys, uint32_t num_keys)
+{
+    memory_arena* scratch = get_scratch_arena();
+    temporary_memory temp = begin_temporary_memory(scratch);
+    T* staging = push_array<T>(scratch, num_keys);
+    if (!staging)
+    {
+        writer->ok = false;
+        end_temporary_memory(temp);
+        return;
+    }
+    memset(staging, 0, num_keys * sizeof(T));
+    for (uint32_t k = 0; k < num_keys; ++k)
+    {
+        staging[k].m_value = keys[k].m_value;
+        staging[k].m_time  = keys[k].m_time;
+    }
+    write_baked_block(writer, at, staging, num_keys * sizeof(T));
+    end_temporary_memory(temp);
+}
+
+/*
+    Bakes whatever the entity currently holds. For characters that is the skeleton and the loaded
+    animations as well, channels are written under the name of the joint they drive.
+*/
+static bool write_baked_asset(entity* p_entity, character* p_character, uint32_t first_anim, uint32_t num_animations, const char* path)
+{
+    uint32_t num_meshes = p_entity ? p_entity->m_num_meshes : 0;
+    uint32_t num_joints = p_character ? p_character->m_num_joints : 0;
+    //animation files only carry channel names, the skeleton comes from the model
+    uint32_t num_baked_joints = p_entity ? num_joints : 0;
+
+    memory_arena* scratch = get_scratch_arena();
+    temporary_memory temp = begin_temporary_memory(scratch);
+
+    baked_asset_header header = {};
+    baked_mesh*        meshes     = push_array<baked_mesh>(scratch, num_meshes);
+    baked_texture**    textures   = push_array<baked_texture*>(scratch, num_meshes);
+    baked_joint*       joints     = push_array<baked_joint>(scratch, num_baked_joints);
+    baked_animation*   animations = push_array<baked_animation>(scratch, num_animations);
+    baked_channel**    channels   = push_array<baked_channel*>(scratch, num_animations);
+
+    //layout pass
+    uint64_t cursor = 0;
+    reserve_baked_block(&cursor, sizeof(baked_asset_header));
+    header.magic             = BAKED_ASSET_MAGIC;
+    header.version           = BAKED_ASSET_VERSION;
+    header.layout            = baked_asset_layout();
+    header.num_meshes        = num_meshes;
+    header.num_joints        = num_baked_joints;
+    header.num_animations    = num_animations;
+    header.meshes_offset     = reserve_baked_block(&cursor, num_meshes * sizeof(baked_mesh));
+    header.joints_offset     = reserve_baked_block(&cursor, num_baked_joints * sizeof(baked_joint));
+    header.animations_offset = reserve_baked_block(&cursor, num_animations * sizeof(baked_animation));
+
+    for (uint32_t i = 0; i < num_meshes; ++i)
+    {
+        mesh* p_mesh = p_entity->m_meshes + i;
+        baked_mesh* p_baked = meshes + i;
+        memset(p_baked, 0, sizeof(baked_mesh));
+        p_baked->global_inv_transform = p_mesh->m_global_inv_transform;
+        p_baked->num_vertices    = p_mesh->m_num_vertices;
+        p_baked->num_indices     = p_mesh->m_num_indices;
+        p_baked->num_textures    = p_mesh->m_num_textures;
+        p_baked->vertices_offset = reserve_baked_block(&cursor, p_mesh->m_num_vertices * sizeof(vertex));
+        p_baked->indices_offset  = reserve_baked_block(&cursor, p_mesh->m_num_indices * sizeof(uint32_t));
+        p_baked->textures_offset = reserve_baked_block(&cursor, p_mesh->m_num_textures * sizeof(baked_texture));
+
+        textures[i] = push_array<baked_texture>(scratch, p_mesh->m_num_textures);
+        memset(textures[i], 0, p_mesh->m_num_textures * sizeof(baked_texture));
+        for (uint32_t j = 0; j < p_mesh->m_num_textures; ++j)
+        {
+            snprintf(textures[i][j].type, BAKED_TEXTURE_TYPE_LENGTH, "%s", get_string(p_mesh->m_textures[j].m_type));
+            snprintf(textures[i][j].path, MAX_ASSET_PATH_LENGTH, "%s", get_string(p_mesh->m_textures[j].m_path));
+        }
+    }
+
+    memset(joints, 0, num_baked_joints * sizeof(baked_joint));
+    for (uint32_t i = 0; i < num_baked_joints; ++i)
+    {
+        joint* p_joint = p_character->m_skeleton + i;
+        joints[i].transformation = p_joint->m_transformation;
+        joints[i].offset         = p_joint->m_offset;
+        joints[i].parent         = p_joint->m_parent;
+        snprintf(joints[i].name, MAX_BONE_NAME_LEN, "%s", get_string(p_joint->m_name));
+    }
+
+    for (uint32_t i = 0; i < num_animations; ++i)
+    {
+        skeletal_animation* p_anim = p_character->m_animations + first_anim + i;
+        baked_animation* p_baked = animations + i;
+        memset(p_baked, 0, sizeof(baked_animation));
+        p_baked->duration      = p_anim->m_duration;
+        p_baked->ticks_per_sec = p_anim->m_ticks_per_sec;
+
+        //the runtime channel array is indexed by joint, only the animated ones are written
+        for (uint32_t j = 0; j < num_joints; ++j)
+        {
+            if (p_anim->m_channels[j].m_bone_id != 0xFF)
+            {
+                p_baked->num_channels++;
+            }
+        }
+        p_baked->channels_offset = reserve_baked_block(&cursor, p_baked->num_channels * sizeof(baked_channel));
+
+        channels[i] = push_array<baked_channel>(scratch, p_baked->num_channels);
+        memset(channels[i], 0, p_baked->num_channels * sizeof(baked_channel));
+        uint32_t channel_index = 0;
+        for (uint32_t j = 0; j < num_joints; ++j)
+        {
+            anim_node* p_node = p_anim->m_channels + j;
+            if (p_node->m_bone_id == 0xFF)
+            {
+                continue;
+            }
+            baked_channel* p_channel = channels[i] + channel_index++;
+            snprintf(p_channel->name, MAX_BONE_NAME_LEN, "%s", get_string(p_node->node_name));
+            p_channel->num_position_keys    = p_node->m_num_position_keys;
+            p_channel->num_rotation_keys    = p_node->m_num_rotation_keys;
+            p_channel->num_scale_keys       = p_node->m_num_scale_keys;
+            p_channel->position_keys_offset = reserve_baked_block(&cursor, p_node->m_num_position_keys * sizeof(pos_key));
+            p_channel->rotation_keys_offset = reserve_baked_block(&cursor, p_node->m_num_rotation_keys * sizeof(quat_key));
+            p_channel->scale_keys_offset    = reserve_baked_block(&cursor, p_node->m_num_scale_keys * sizeof(scale_key));
+        }
+    }
+    header.file_size = cursor;
+
+    //write pass, same order as above
+    baked_writer writer = {};
+    writer.file = fopen(path, "wb");
+    if (!writer.file)
+    {
+        printf("Can not open %s for writing\n", path);
+        end_temporary_memory(temp);
+        return false;
+    }
+    writer.ok = true;
+
+    write_baked_block(&writer, 0, &header, sizeof(header));
+    write_baked_block(&writer, header.meshes_offset, meshes, num_meshes * sizeof(baked_mesh));
+    write_baked_block(&writer, header.joints_offset, joints, num_baked_joints * sizeof(baked_joint));
+    write_baked_block(&writer, header.animations_offset, animations, num_animations * sizeof(baked_animation));
+
+    for (uint32_t i = 0; i < num_meshes; ++i)
+    {
+        mesh* p_mesh = p_entity->m_meshes + i;
+        write_baked_block(&writer, meshes[i].vertices_offset, p_mesh->m_vertices, p_mesh->m_num_vertices * sizeof(vertex));
+        write_baked_block(&writer, meshes[i].indices_offset, p_mesh->m_indices, p_mesh->m_num_indices * sizeof(uint32_t));
+        write_baked_block(&writer, meshes[i].textures_offset, textures[i], p_mesh->m_num_textures * sizeof(baked_texture));
+    }
+
+    for (uint32_t i = 0; i < num_animations; ++i)
+    {
+        skeletal_animation* p_anim = p_character->m_animations + first_anim + i;
+        write_baked_block(&writer, animations[i].channels_offset, channels[i], animations[i].num_channels * sizeof(baked_channel));
+
+        uint32_t channel_index = 0;
+        for (uint32_t j = 0; j < num_joints; ++j)
+        {
+            anim_node* p_node = p_anim->m_channels + j;
+            if (p_node->m_bone_id == 0xFF)
+            {
+                continue;
+            }
+            baked_channel* p_channel = channels[i] + channel_index++;
+            write_baked_keys(&writer, p_channel->position_keys_offset, p_node->m_position_keys, p_node->m_num_position_keys);
+            write_baked_keys(&writer, p_channel->rotation_keys_offset, p_node->m_rotation_keys, p_node->m_num_rotation_keys);
+            write_baked_keys(&writer, p_channel->scale_keys_offset, p_node->m_scale_keys, p_node->m_num_scale_keys);
+        }
+    }
+
+    fclose(writer.file);
+    end_temporary_memory(temp);
+
+    if (!writer.ok || writer.offset != header.file_size)
+    {
+        printf("Failed to write %s\n", path);
+        remove(path);
+        return false;
+    }
+    printf("Baked %s: %llu bytes\n", path, (unsigned long long)header.file_size);
+    return true;
+}
+
+bool write_baked_model(entity* p_entity, const char* path)
+{
+    if (p_entity->m_type != ET_CHARACTER)
+    {
+        return write_baked_asset(p_entity, NULL, 0, 0, path);
+    }
+    character* p_character = (character*)p_entity;
+    return write_baked_asset(p_entity, p_character, 0, p_character->m_num_animations, path);
+}
+
+bool write_baked_animation(character* p_character, uint32_t anim_index, const char* path)
+{
+    assert(anim_index < p_character->m_num_animations);
+    return write_baked_asset(NULL, p_character, anim_index, 1, path);
+}
+
+//hashed a chunk at a time, chained through the seed, so a source of any size fits in scratch memory
+static bool hash_file_contents(const char* path, uint64_t seed, uint64_t* out_hash)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    memory_arena* scratch = get_scratch_arena();
+    temporary_memory temp = begin_temporary_memory(scratch);
+    uint8_t* chunk = (uint8_t*)push_size(scratch, IMPORT_CACHE_CHUNK_SIZE);
+
+    uint64_t hash = seed;
+    bool ok = chunk != NULL;
+    while (ok)
+    {
+        size_t read = fread(chunk, 1, IMPORT_CACHE_CHUNK_SIZE, file);
+        if (read == 0)
+        {
+            ok = !ferror(file);
+            break;
+        }
+        hash = hash64(chunk, read, hash);
+    }
+    fclose(file);
+    end_temporary_memory(temp);
+
+    *out_hash = hash;
+    return ok;
+}
+
+//chunked the same way as hash_file_contents, both give the same hash
+static uint64_t hash_contents(const void* data, uint64_t size, uint64_t seed)
+{
+    uint64_t hash = seed;
+    for (uint64_t offset = 0; offset < size; offset += IMPORT_CACHE_CHUNK_SIZE)
+    {
+        uint64_t chunk = size - offset < IMPORT_CACHE_CHUNK_SIZE ? size - offset : IMPORT_CACHE_CHUNK_SIZE;
+        hash = hash64((const uint8_t*)data + offset, chunk, hash);
+    }
+    return hash;
+}
+
+bool get_import_cache_path(const char* source_path, uint64_t seed, char* out_buffer, uint32_t out_size,
+                           const void* source_data, uint64_t source_size)
+{
+    uint64_t hash = 0;
+    if (source_data)
+    {
+        hash = hash_contents(source_data, source_size, seed);
+    }
+    else if (!hash_file_contents(source_path, seed, &hash))
+    {
+        return false;
+    }
+    snprintf(out_buffer, out_size, "%s/%016llx%s", IMPORT_CACHE_DIRECTORY, (unsigned long long)hash, BAKED_ASSET_EXTENSION);
+    return true;
+}
+
+/*
+    Written under a name of its own first and renamed into place, so a job thread loading the same
+    source never reads half a file. If someone else got there first their file is just as good.
+*/
+static bool write_cache_file(entity* p_entity, character* p_character, uint32_t first_anim, uint32_t num_animations, const char* cache_path)
+{
+    static thread_local char writer_tag;
+
+#ifdef _WIN32
+    _mkdir(IMPORT_CACHE_DIRECTORY);
+#else
+    mkdir(IMPORT_CACHE_DIRECTORY, 0755);
+#endif
+
+    char temp_path[MAX_ASSET_PATH_LENGTH];
+    snprintf(temp_path, sizeof(temp_path), "%s.%p.tmp", cache_path, (void*)&writer_tag);
+    if (!write_baked_asset(p_entity, p_character, first_anim, num_animations, temp_path))
+    {
+        return false;
+    }
+    if (rename(temp_path, cache_path) != 0)
+    {
+        remove(temp_path);
+    }
+    return true;
+}
+
+bool write_cached_model(entity* p_entity, const char* cache_path)
+{
+    if (p_entity->m_type != ET_CHARACTER)
+    {
+        return write_cache_file(p_entity, NULL, 0, 0, cache_path);
+    }
+    character* p_character = (character*)p_entity;
+    return write_cache_file(p_entity, p_character, 0, p_character->m_num_animations, cache_path);
+}
+
+bool write_cached_animation(character* p_character, uint32_t anim_index, const char* cache_path)
+{
+    assert(anim_index < p_character->m_num_animations);
+    return write_cache_file(NULL, p_character, anim_index, 1, cache_path);
+}
+
+static uint8_t* read_baked_file(const char* path, memory_arena* arena, uint64_t* out_size)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    uint8_t* result = NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (size > 0)
+    {
+        result = (uint8_t*)push_size(arena, (uint64_t)size, CACHE_LINE_SIZE);
+        if (result && fread(result, 1, (size_t)size, file) != (size_t)size)
+        {
+            printf("Failed to read %s\n", path);
+            result = NULL;
+        }
+    }
+    fclose(file);
+
+    *out_size = (uint64_t)size;
+    return result;
+}
+
+static bool baked_range_ok(uint64_t file_size, uint64_t offset, uint64_t count, uint64_t element_size)
+{
+    return (offset % BAKED_ASSET_ALIGNMENT) == 0 && offset <= file_size && count <= (file_size - offset) / element_size;
+}
+
+static bool validate_baked_asset(uint8_t* blob, uint64_t size, const char* path)
+{
+    baked_asset_header* header = (baked_asset_header*)blob;
+    if (header->magic != BAKED_ASSET_MAGIC || header->version != BAKED_ASSET_VERSION ||
+        header->layout != baked_asset_layout())
+    {
+        printf("%s was baked by another version, rebake it\n", path);
+        return false;
+    }
+
+    bool result = header->file_size == size &&
+                  header->num_joints <= MAX_NUM_BONES &&
+                  baked_range_ok(size, header->meshes_offset, header->num_meshes, sizeof(baked_mesh)) &&
+                  baked_range_ok(size, header->joints_offset, header->num_joints, sizeof(baked_joint)) &&
+                  baked_range_ok(size, header->animations_offset, header->num_animations, sizeof(baked_animation));
+
+    baked_joint* joints = (baked_joint*)(blob + header->joints_offset);
+    for (uint32_t i = 0; result && i < header->num_joints; ++i)
+    {
+        result = i == 0 || joints[i].parent < i;
+    }
+
+    baked_mesh* meshes = (baked_mesh*)(blob + header->meshes_offset);
+    for (uint32_t i = 0; result && i < header->num_meshes; ++i)
+    {
+        result = baked_range_ok(size, meshes[i].vertices_offset, meshes[i].num_vertices, sizeof(vertex)) &&
+                 baked_range_ok(size, meshes[i].indices_offset, meshes[i].num_indices, sizeof(uint32_t)) &&
+                 baked_range_ok(size, meshes[i].textures_offset, meshes[i].num_textures, sizeof(baked_texture));
+    }
+
+    baked_animation* animations = (baked_animation*)(blob + header->animations_offset);
+    for (uint32_t i = 0; result && i < header->num_animations; ++i)
+    {
+        //every channel animates a joint of its own
+        result = animations[i].num_channels <= MAX_NUM_BONES &&
+                 baked_range_ok(size, animations[i].channels_offset, animations[i].num_channels, sizeof(baked_channel));
+        baked_channel* channels = (baked_channel*)(blob + animations[i].channels_offset);
+        for (uint32_t j = 0; result && j < animations[i].num_channels; ++j)
+        {
+            result = baked_range_ok(size, channels[j].position_keys_offset, channels[j].num_position_keys, sizeof(pos_key)) &&
+                     baked_range_ok(size, channels[j].rotation_keys_offset, channels[j].num_rotation_keys, sizeof(quat_key)) &&
+                     baked_range_ok(size, channels[j].scale_keys_offset, channels[j].num_scale_keys, sizeof(scale_key));
+        }
+    }
+
+    if (!result)
+    {
+        printf("%s is damaged\n", path);
+    }
+    return result;
+}
+
+static void bind_baked_animation(character* p_character, uint8_t* blob, baked_animation* p_baked, memory_arena* animation_arena)
+{
+    skeletal_animation* p_anim = p_character->m_animations + p_character->m_num_animations;
+
+    p_anim->m_ticks_per_sec    = p_baked->ticks_per_sec;
+    p_anim->m_duration         = p_baked->duration;
+    p_anim->m_num_channels     = p_baked->num_channels;
+    p_anim->m_last_time_index  = 0;
+    p_anim->m_last_time        = 0.0f;
+    p_anim->m_channels = push_array<anim_node>(animation_arena, p_character->m_num_joints, CACHE_LINE_SIZE);
+
+    for (uint32_t j = 0; j < p_character->m_num_joints; ++j)
+    {
+        p_anim->m_channels[j].m_bone_id = 0xFF;
+    }
+
+    baked_channel* channels = (baked_channel*)(blob + p_baked->channels_offset);
+    for (uint32_t j = 0; j < p_baked->num_channels; ++j)
+    {
+        baked_channel* p_channel = channels + j;
+        string_id name = find_string(p_channel->name, (uint32_t)strnlen(p_channel->name, MAX_BONE_NAME_LEN));
+        uint8_t bone_index = name != NO_STRING ? find_bone(p_character, name) : 0xFF;
+        if (bone_index == 0xFF || bone_index >= p_character->m_num_joints)
+        {
+            printf("Animation channel %s has no joint in the skeleton\n", p_channel->name);
+            continue;
+        }
+
+        anim_node* p_anim_node = p_anim->m_channels + bone_index;
+        p_anim_node->m_bone_id           = bone_index;
+        p_anim_node->node_name           = name;
+        p_anim_node->m_num_position_keys = p_channel->num_position_keys;
+        p_anim_node->m_num_rotation_keys = p_channel->num_rotation_keys;
+        p_anim_node->m_num_scale_keys    = p_channel->num_scale_keys;
+        p_anim_node->m_position_keys     = (pos_key*)(blob + p_channel->position_keys_offset);
+        p_anim_node->m_rotation_keys     = (quat_key*)(blob + p_channel->rotation_keys_offset);
+        p_anim_node->m_scale_keys        = (scale_key*)(blob + p_channel->scale_keys_offset);
+    }
+    p_character->m_num_animations++;
+}
+
+//the blob is only read from here on, it may be a read only mapping
+bool load_baked_model_from_memory(entity* p_entity, const void* data, uint64_t size, const char* name,
+                                  uint32_t num_animations, memory_arena* mesh_arena, memory_arena* animation_arena)
+{
+    uint8_t* blob = (uint8_t*)data;
+    if (size < sizeof(baked_asset_header) || !is_aligned(blob, BAKED_ASSET_ALIGNMENT) ||
+        !validate_baked_asset(blob, size, name))
+    {
+        return false;
+    }
+
+    baked_asset_header* header = (baked_asset_header*)blob;
+    bool is_character = p_entity->m_type == ET_CHARACTER;
+
+    p_entity->m_num_meshes = header->num_meshes;
+    p_entity->m_meshes = push_array<mesh>(mesh_arena, header->num_meshes);
+
+    baked_mesh* meshes = (baked_mesh*)(blob + header->meshes_offset);
+    for (uint32_t i = 0; i < header->num_meshes; ++i)
+    {
+        mesh* p_mesh = p_entity->m_meshes + i;
+        memset(p_mesh, 0, sizeof(mesh));
+        p_mesh->m_global_inv_transform = meshes[i].global_inv_transform;
+        p_mesh->m_vertices     = (vertex*)(blob + meshes[i].vertices_offset);
+        p_mesh->m_indices      = (uint32_t*)(blob + meshes[i].indices_offset);
+        p_mesh->m_num_vertices = meshes[i].num_vertices;
+        p_mesh->m_num_indices  = meshes[i].num_indices;
+        p_mesh->m_num_textures = meshes[i].num_textures;
+        p_mesh->m_textures     = push_array<texture>(mesh_arena, meshes[i].num_textures);
+
+        baked_texture* textures = (baked_texture*)(blob + meshes[i].textures_offset);
+        for (uint32_t j = 0; j < meshes[i].num_textures; ++j)
+        {
+            p_mesh->m_textures[j].m_type  = intern_string(textures[j].type, (uint32_t)strnlen(textures[j].type, BAKED_TEXTURE_TYPE_LENGTH));
+            p_mesh->m_textures[j].m_path  = intern_string(textures[j].path, (uint32_t)strnlen(textures[j].path, MAX_ASSET_PATH_LENGTH));
+            p_mesh->m_textures[j].id      = 0;
+            p_mesh->m_textures[j].m_asset = 0;
+        }
+    }
+
+    if (is_character)
+    {
+        character* p_character = (character*)p_entity;
+        p_character->m_num_joints = header->num_joints;
+        p_character->m_skeleton = push_array<joint>(mesh_arena, header->num_joints, CACHE_LINE_SIZE);
+
+        baked_joint* joints = (baked_joint*)(blob + header->joints_offset);
+        for (uint32_t i = 0; i < header->num_joints; ++i)
+        {
+            joint* p_joint = p_character->m_skeleton + i;
+            p_joint->m_transformation = joints[i].transformation;
+            p_joint->m_offset         = joints[i].offset;
+            p_joint->m_name           = intern_string(joints[i].name, (uint32_t)strnlen(joints[i].name, MAX_BONE_NAME_LEN));
+            p_joint->m_parent         = (uint8_t)joints[i].parent;
+        }
+
+        p_character->m_num_animations = 0;
+        p_character->m_animations = push_array<skeletal_animation>(animation_arena, num_animations);
+        baked_animation* animations = (baked_animation*)(blob + header->animations_offset);
+        for (uint32_t i = 0; i < header->num_animations && i < num_animations; ++i)
+        {
+            bind_baked_animation(p_character, blob, animations + i, animation_arena);
+        }
+    }
+    return true;
+}
+
+bool load_baked_animation_from_memory(character* p_character, const void* data, uint64_t size, const char* name, memory_arena* animation_arena)
+{
+    uint8_t* blob = (uint8_t*)data;
+    if (size < sizeof(baked_asset_header) || !is_aligned(blob, BAKED_ASSET_ALIGNMENT) ||
+        !validate_baked_asset(blob, size, name))
+    {
+        return false;
+    }
+
+    //the character's animations are a fixed array, whatever doesn't fit is left out
+    baked_asset_header* header = (baked_asset_header*)blob;
+    uint32_t room = p_character->m_num_animations < MAX_ANIMATIONS_PER_CHARACTER ?
+                    MAX_ANIMATIONS_PER_CHARACTER - p_character->m_num_animations : 0;
+    if (room == 0)
+    {
+        printf("No room for the animations in %s\n", name);
+        return false;
+    }
+    if (header->num_animations > room)
+    {
+        printf("%s has %u animations, only the first %u are used\n", name, header->num_animations, room);
+    }
+    baked_animation* animations = (baked_animation*)(blob + header->animations_offset);
+    for (uint32_t i = 0; i < header->num_animations && i < room; ++i)
+    {
+        bind_baked_animation(p_character, blob, animations + i, animation_arena);
+    }
+    return true;
+}
+
+bool load_baked_model(entity* p_entity, const char* path, uint32_t num_animations, memory_arena* mesh_arena, memory_arena* animation_arena)
+{
+    //if the file turns out to be unusable its memory goes back
+    temporary_memory temp = begin_temporary_memory(mesh_arena);
+    uint64_t size = 0;
+    uint8_t* blob = read_baked_file(path, mesh_arena, &size);
+    if (!blob || !load_baked_model_from_memory(p_entity, blob, size, path, num_animations, mesh_arena, animation_arena))
+    {
+        end_temporary_memory(temp);
+        return false;
+    }
+    keep_temporary_memory(temp);
+    return true;
+}
+
+bool load_baked_animation(character* p_character, const char* path, memory_arena* animation_arena)
+{
+    temporary_memory temp = begin_temporary_memory(animation_arena);
+    uint64_t size = 0;
+    uint8_t* blob = read_baked_file(path, animation_arena, &size);
+    if (!blob || !load_baked_animation_from_memory(p_character, blob, size, path, animation_arena))
+    {
+        end_temporary_memory(temp);
+        return false;
+    }
+    keep_temporary_memory(temp);
+    return true;
+}
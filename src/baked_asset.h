@@ -0,0 +1,119 @@
+#ifndef BAKED_ASSET_H
+#define BAKED_ASSET_H
+
+#include <stdint.h>
+
+#include "mesh.h"
+#include "memory.h"
+
+/*
+    Binary model/animation format written by the asset baker (tools/asset_baker) and loaded with no
+    Assimp in the process. The whole file is read into an arena and vertex, index and keyframe arrays
+    are used straight from it, so their records are laid out exactly like the runtime structs. Only the
+    structs that hold pointers or get mutated (mesh, joint, skeletal_animation, anim_node) are built
+    separately and point into the blob. The blob itself is never written to after loading.
+    All offsets are from the start of the file and aligned to BAKED_ASSET_ALIGNMENT.
+*/
+#define BAKED_ASSET_MAGIC     0x54534146 //'FAST'
+#define BAKED_ASSET_VERSION   1
+#define BAKED_ASSET_ALIGNMENT 32
+#define BAKED_ASSET_EXTENSION ".fasset"
+#define BAKED_TEXTURE_TYPE_LENGTH 32
+
+/*
+    Sources without a baked file next to them are imported once and cached in the baked format,
+    under the hash of the source's contents and of everything else that changes the import result
+    (the seed). An edited source gets a new name, stale files are simply never looked up again.
+*/
+#define IMPORT_CACHE_DIRECTORY  "Cache"
+#define IMPORT_CACHE_CHUNK_SIZE Megabytes(1)
+
+//files written by a build with different struct sizes can't be used in place
+constexpr uint32_t baked_asset_layout(void)
+{
+    return (uint32_t)(sizeof(vertex) | (sizeof(quat_key) << 8) | (sizeof(pos_key) << 16) | (sizeof(scale_key) << 24));
+}
+
+struct baked_asset_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t layout;
+    uint32_t num_meshes;
+    uint32_t num_joints;
+    uint32_t num_animations;
+    uint64_t file_size;
+    uint64_t meshes_offset;     //baked_mesh[num_meshes]
+    uint64_t joints_offset;     //baked_joint[num_joints]
+    uint64_t animations_offset; //baked_animation[num_animations]
+};
+
+struct baked_mesh
+{
+    glm::mat4 global_inv_transform;
+    uint64_t  vertices_offset;  //vertex[num_vertices]
+    uint64_t  indices_offset;   //uint32_t[num_indices]
+    uint64_t  textures_offset;  //baked_texture[num_textures]
+    uint32_t  num_vertices;
+    uint32_t  num_indices;
+    uint32_t  num_textures;
+    uint32_t  pad;
+};
+
+struct baked_texture
+{
+    char type[BAKED_TEXTURE_TYPE_LENGTH];
+    char path[MAX_ASSET_PATH_LENGTH];
+};
+
+struct baked_joint
+{
+    glm::mat4 transformation;
+    glm::mat4 offset;
+    char      name[MAX_BONE_NAME_LEN];
+    uint32_t  parent;
+    uint32_t  pad[3];
+};
+
+//channels are stored by bone name and bound to the skeleton when loaded
+struct baked_channel
+{
+    char     name[MAX_BONE_NAME_LEN];
+    uint64_t position_keys_offset;
+    uint64_t rotation_keys_offset;
+    uint64_t scale_keys_offset;
+    uint32_t num_position_keys;
+    uint32_t num_rotation_keys;
+    uint32_t num_scale_keys;
+    uint32_t pad;
+};
+
+struct baked_animation
+{
+    double   duration;
+    double   ticks_per_sec;
+    uint64_t channels_offset;   //baked_channel[num_channels]
+    uint32_t num_channels;
+    uint32_t pad;
+};
+
+//source path with its extension swapped for the baked one
+void get_baked_path(const char* source_path, const char* extension, char* out_buffer, uint32_t out_size);
+void get_baked_asset_path(const char* source_path, char* out_buffer, uint32_t out_size);
+//meshes, plus skeleton and animations for characters
+bool write_baked_model(entity* p_entity, const char* path);
+bool write_baked_animation(character* p_character, uint32_t anim_index, const char* path);
+//false if the source can't be read. Hashes source_data instead of reading the file when it was read already
+bool get_import_cache_path(const char* source_path, uint64_t seed, char* out_buffer, uint32_t out_size,
+                           const void* source_data = NULL, uint64_t source_size = 0);
+bool write_cached_model(entity* p_entity, const char* cache_path);
+bool write_cached_animation(character* p_character, uint32_t anim_index, const char* cache_path);
+//false if the file is missing or unusable, the caller falls back to importing the source file
+bool load_baked_model(entity* p_entity, const char* path, uint32_t num_animations, memory_arena* mesh_arena, memory_arena* animation_arena);
+bool load_baked_animation(character* p_character, const char* path, memory_arena* animation_arena);
+//same, for a blob that is already in memory (e.g. in the mapped pack), it has to outlive the entity
+bool load_baked_model_from_memory(entity* p_entity, const void* data, uint64_t size, const char* name,
+                                  uint32_t num_animations, memory_arena* mesh_arena, memory_arena* animation_arena);
+bool load_baked_animation_from_memory(character* p_character, const void* data, uint64_t size, const char* name, memory_arena* animation_arena);
+
+#endif
@@ -1,8 +1,11 @@
 #include "character.h"
 #include "world.h"
+#include "pool.h"
 
-static character* m_character_storage;
-static uint32_t   m_num_characters;
+static memory_arena*       m_character_arena;
+static pool<character>     m_character_pool;
+static glm::mat4*          m_pose_buffers;      //final and local transforms for every pool slot
+static skeletal_animation* m_animation_buffers; //playback state for every pool slot, the keys are shared
 
 static void copy_character_info(character* to, character* from)
 {
@@ -15,20 +18,16 @@ static void copy_character_info(character* to, character* from)
 
 void characters_init(void)
 {
-	m_character_storage = (character*)push_size((MAX_NUM_CHARACTERS) * sizeof(character));
-	m_num_characters = 0;
+	m_character_arena = create_sub_arena("characters", CHARACTER_MEMORY_BUDGET);
+	pool_init(&m_character_pool, m_character_arena, MAX_NUM_CHARACTERS);
+	//pose buffers belong to the slot, so a reused slot doesn't push new ones
+	m_pose_buffers = push_array<glm::mat4>(m_character_arena, MAX_NUM_CHARACTERS * MAX_NUM_BONES * 2, CACHE_LINE_SIZE);
+	m_animation_buffers = push_array<skeletal_animation>(m_character_arena, MAX_NUM_CHARACTERS * MAX_ANIMATIONS_PER_CHARACTER);
 }
 
 character* put_character_in_storage(character* p_character)
 {
-	character* result = NULL;
-	//check if space exists
-	if (m_num_characters == MAX_NUM_CHARACTERS)
-	{
-		return result;
-	}
-
-	result = m_character_storage + m_num_characters++;
+	character* result = pool_alloc(&m_character_pool);
 	return result;
 }
 
@@ -37,18 +36,42 @@ character* create_character(character* p_character)
 	character* result = NULL;
 	
 	result = (character*)map_entity_to_world_chunk(p_character);
+	if (!result)
+	{
+		return result;
+	}
 	memcpy(result, p_character, sizeof(character));
 	result->m_id   = get_next_unique_entity_id();
-	result->m_final_transformations = (glm::mat4*)push_size(sizeof(glm::mat4) * MAX_NUM_BONES);
-	result->m_local_transformations = (glm::mat4*)push_size(sizeof(glm::mat4) * MAX_NUM_BONES);
+	//pose buffers are rewritten every frame, keep them on their own cache lines
+	glm::mat4* pose = m_pose_buffers + pool_index_of(&m_character_pool, result) * MAX_NUM_BONES * 2;
+	result->m_final_transformations = pose;
+	result->m_local_transformations = pose + MAX_NUM_BONES;
 	result->m_num_transformations = 0;
+	result->m_animations = m_animation_buffers + pool_index_of(&m_character_pool, result) * MAX_ANIMATIONS_PER_CHARACTER;
+	result->m_num_animations = 0;
 
 	return result;
 }
 
+void destroy_character(character* p_character)
+{
+	remove_entity_from_world(p_character);
+	release_entity_assets(p_character);
+	//its slot goes back once the last load is done
+	release_asset_load(p_character->m_asset);
+	p_character->m_asset = 0;
+	p_character->m_id = 0;
+	pool_free(&m_character_pool, p_character);
+}
+
+uint32_t get_num_characters(void)
+{
+	return m_character_pool.m_count;
+}
+
 character* get_character_by_index(uint32_t index)
 {
 	character* result = NULL;
-	result = m_character_storage + index;
+	result = pool_get(&m_character_pool, index);
 	return result;
 }
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include "shader.h"
 #include "entity.h"
 
+#define MAX_ANIMATIONS_PER_CHARACTER 8
+
 struct character : public entity
 {
     joint*              m_skeleton;
@@ -19,6 +21,9 @@ struct character : public entity
     uint32_t            m_num_transformations;
     uint32_t            m_num_joints;
     uint32_t            m_num_animations;
+    //animations loaded for this character on top of its model's own, shared with other characters
+    asset_id            m_animation_assets[MAX_ANIMATIONS_PER_CHARACTER];
+    uint32_t            m_num_animation_assets;
     glm::vec3           m_move_target;
     glm::quat           m_rotate_target;
     bool                m_should_move;    //get rid of this or combine into "flags"?
@@ -28,6 +33,9 @@ struct character : public entity
 void       characters_init(void);
 character* put_character_in_storage(character* p_character);
 character* create_character(character* p_character);
+void       destroy_character(character* p_character);
+uint32_t   get_num_characters(void);
+character* get_character_by_index(uint32_t index);
 
 #endif
 
@@ -1,11 +1,11 @@
 #include "collision.h"
+#include "thread.h"
 
 static bool test_wall(float wall_x, float rel_x, float rel_y, float player_delta_x, float player_delta_y, 
                       float* t_min, float min_y, float max_y)
 {
     bool hit = false;
 
-    float t_epsilon = 0.01f;
     if(player_delta_x != 0.0f)
     {
         float t_result = (wall_x - rel_x)/player_delta_x;
@@ -14,7 +14,7 @@ static bool test_wall(float wall_x, float rel_x, float rel_y, float player_delta
         {
             if((y >= min_y) && (y <= max_y))
             {
-                *t_min = MAX(0.0f, t_result - t_epsilon);
+                *t_min = t_result;
                 hit = true;
             }
         }
@@ -22,6 +22,88 @@ static bool test_wall(float wall_x, float rel_x, float rel_y, float player_delta
     return hit;
 }
 
+struct sweep_hit
+{
+    float     t_min; //where it touches, the epsilon comes off once all ranges are in
+    glm::vec2 wall_normal;
+    entity*   hit_entity;
+    uint32_t  index; //of hit_entity in the chunk
+};
+
+//one step of move_entity against every entity of a chunk, which ranges of them run in parallel
+struct entity_sweep
+{
+    entity*          p_entity;
+    world_chunk*     p_chunk;
+    glm::vec2        player_delta;
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    sweep_hit        hit;
+};
+
+static void sweep_entities(uint32_t begin, uint32_t end, void* arg)
+{
+    entity_sweep* sweep = (entity_sweep*)arg;
+    entity* p_entity = sweep->p_entity;
+    glm::vec2 player_delta = sweep->player_delta;
+    sweep_hit hit = {};
+    hit.t_min = 1.0f;
+
+    for(uint32_t index = begin; index < end; ++index)
+    {
+        entity* test_entity = sweep->p_chunk->m_entities[index];
+        float diameter_w = get_entity_width(test_entity) + get_entity_width(p_entity);
+        float diameter_h = get_entity_height(test_entity) + get_entity_height(p_entity);
+        glm::vec2 min_corner = {-0.5f*diameter_w, -0.5f*diameter_h};
+        glm::vec2 max_corner = {0.5f*diameter_w, 0.5f*diameter_h};
+        glm::vec3 rel3 = p_entity->m_p - test_entity->m_p;
+        glm::vec2 rel = { rel3.x, rel3.z};
+
+        if(test_wall(min_corner.x, rel.x, rel.y, player_delta.x, player_delta.y,
+                    &hit.t_min, min_corner.y, max_corner.y))
+        {
+            hit.wall_normal = {-1, 0};
+            hit.hit_entity = test_entity;
+            hit.index = index;
+        }
+        if(test_wall(max_corner.x, rel.x, rel.y, player_delta.x, player_delta.y,
+                    &hit.t_min, min_corner.y, max_corner.y))
+        {
+            hit.wall_normal = {1,0};
+            hit.hit_entity = test_entity;
+            hit.index = index;
+        }
+        if(test_wall(min_corner.y, rel.y, rel.x, player_delta.y, player_delta.x, 
+                    &hit.t_min, min_corner.x, max_corner.x))
+        {
+            hit.wall_normal = {0, -1};
+            hit.hit_entity = test_entity;
+            hit.index = index;
+        }
+        if(test_wall(max_corner.y, rel.y, rel.x, player_delta.y, player_delta.x,
+                    &hit.t_min, min_corner.x, max_corner.x))
+        {
+            hit.wall_normal = {0, 1};
+            hit.hit_entity = test_entity;
+            hit.index = index;
+        }
+    }
+    if(!hit.hit_entity)
+    {
+        return;
+    }
+
+    //earliest hit wins, on a tie the lower index like within a range, so the order ranges finish in doesn't matter
+    while(sweep->lock.test_and_set(std::memory_order_acquire))
+    {
+    }
+    if(!sweep->hit.hit_entity || hit.t_min < sweep->hit.t_min ||
+       (hit.t_min == sweep->hit.t_min && hit.index < sweep->hit.index))
+    {
+        sweep->hit = hit;
+    }
+    sweep->lock.clear(std::memory_order_release);
+}
+
 void move_entity(entity* p_entity, sim_region* p_region, float dt, move_spec spec)
 {
     if(spec.unit_max_accel_vector)
@@ -47,46 +129,19 @@ void move_entity(entity* p_entity, sim_region* p_region, float dt, move_spec spe
 
         for(uint32_t iteration = 0; iteration < 4; ++iteration)
         {
-            float t_min = 1.0f;
-            glm::vec2 wall_normal = {};
-            entity* hit_entity = NULL;
             glm::vec2 desired_position = glm::vec2(p_entity->m_p.x, p_entity->m_p.z) + player_delta;
 
-            for(uint32_t index = 0; index < p_chunk->m_num_entities; ++index)
-            {
-                entity* test_entity = p_chunk->m_entities[index];
-                float diameter_w = get_entity_width(test_entity) + get_entity_width(p_entity);
-                float diameter_h = get_entity_height(test_entity) + get_entity_height(p_entity);
-                glm::vec2 min_corner = {-0.5f*diameter_w, -0.5f*diameter_h};
-                glm::vec2 max_corner = {0.5f*diameter_w, 0.5f*diameter_h};
-                glm::vec3 rel3 = p_entity->m_p - test_entity->m_p;
-                glm::vec2 rel = { rel3.x, rel3.z};
-
-                if(test_wall(min_corner.x, rel.x, rel.y, player_delta.x, player_delta.y,
-                            &t_min, min_corner.y, max_corner.y))
-                {
-                    wall_normal = {-1, 0};
-                    hit_entity = test_entity;
-                }
-                if(test_wall(max_corner.x, rel.x, rel.y, player_delta.x, player_delta.y,
-                            &t_min, min_corner.y, max_corner.y))
-                {
-                    wall_normal = {1,0};
-                    hit_entity = test_entity;
-                }
-                if(test_wall(min_corner.y, rel.y, rel.x, player_delta.y, player_delta.x, 
-                            &t_min, min_corner.x, max_corner.x))
-                {
-                    wall_normal = {0, -1};
-                    hit_entity = test_entity;
-                }
-                if(test_wall(max_corner.y, rel.y, rel.x, player_delta.y, player_delta.x,
-                            &t_min, min_corner.x, max_corner.x))
-                {
-                    wall_normal = {0, 1};
-                    hit_entity = test_entity;
-                }
-            }
+            entity_sweep sweep = {};
+            sweep.p_entity     = p_entity;
+            sweep.p_chunk      = p_chunk;
+            sweep.player_delta = player_delta;
+            sweep.hit.t_min    = 1.0f;
+            parallel_for(p_chunk->m_num_entities, 0, &sweep_entities, &sweep);
+            //stop just short of what was hit
+            float t_epsilon = 0.01f;
+            float t_min = sweep.hit.hit_entity ? MAX(0.0f, sweep.hit.t_min - t_epsilon) : 1.0f;
+            glm::vec2 wall_normal = sweep.hit.wall_normal;
+            entity* hit_entity = sweep.hit.hit_entity;
             
             p_entity->m_p = p_entity->m_p + glm::vec3(player_delta.x, 0.0f, player_delta.y) * glm::vec3(t_min);
 
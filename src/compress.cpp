@@ -0,0 +1,211 @@
+#include "compress.h"
+
+#include <string.h>
+
+static inline uint32_t read_u32(const uint8_t* p)
+{
+    uint32_t result;
+    memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+static inline uint32_t hash_sequence(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - COMPRESS_HASH_BITS);
+}
+
+//15 in the nibble, then runs of 255 and the rest
+static inline uint8_t* write_length(uint8_t* op, uint64_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+//match_length 0 is the last sequence, literals only
+static uint8_t* write_sequence(uint8_t* op, const uint8_t* literals, uint64_t num_literals, uint32_t offset, uint64_t match_length)
+{
+    uint8_t* token = op++;
+    *token = (uint8_t)((num_literals < 15 ? num_literals : 15) << 4);
+    if (num_literals >= 15)
+    {
+        op = write_length(op, num_literals - 15);
+    }
+    memcpy(op, literals, num_literals);
+    op += num_literals;
+
+    if (match_length == 0)
+    {
+        return op;
+    }
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    uint64_t length = match_length - COMPRESS_MIN_MATCH;
+    *token |= (uint8_t)(length < 15 ? length : 15);
+    if (length >= 15)
+    {
+        op = write_length(op, length - 15);
+    }
+    return op;
+}
+
+/*
+    Positions in the table are from the start of the block, a candidate is checked against the bytes
+    themselves so stale or colliding slots only cost a miss. The step grows while nothing matches, so
+    data that doesn't compress (already compressed sounds) goes through quickly.
+*/
+uint64_t compress_block(const void* src, uint64_t size, void* dst, uint64_t dst_capacity)
+{
+    if (dst_capacity < compress_bound(size))
+    {
+        return 0;
+    }
+
+    const uint8_t* in     = (const uint8_t*)src;
+    const uint8_t* end    = in + size;
+    const uint8_t* ip     = in;
+    const uint8_t* anchor = in;
+    uint8_t* op = (uint8_t*)dst;
+
+    if (size > COMPRESS_MATCH_LIMIT)
+    {
+        static thread_local uint32_t table[1 << COMPRESS_HASH_BITS];
+        memset(table, 0, sizeof(table));
+
+        const uint8_t* match_limit = end - COMPRESS_MATCH_LIMIT;
+        const uint8_t* match_end   = end - COMPRESS_LAST_LITERALS;
+        while (ip < match_limit)
+        {
+            uint32_t sequence = read_u32(ip);
+            uint32_t hash = hash_sequence(sequence);
+            const uint8_t* candidate = in + table[hash];
+            table[hash] = (uint32_t)(ip - in);
+            if (candidate >= ip || ip - candidate > COMPRESS_MAX_OFFSET || read_u32(candidate) != sequence)
+            {
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            //grow it backwards over literals that match too, then forwards
+            while (ip > anchor && candidate > in && ip[-1] == candidate[-1])
+            {
+                --ip;
+                --candidate;
+            }
+            const uint8_t* match = ip + COMPRESS_MIN_MATCH;
+            const uint8_t* from  = candidate + COMPRESS_MIN_MATCH;
+            while (match < match_end && *match == *from)
+            {
+                ++match;
+                ++from;
+            }
+
+            op = write_sequence(op, anchor, (uint64_t)(ip - anchor), (uint32_t)(ip - candidate), (uint64_t)(match - ip));
+            ip = match;
+            anchor = ip;
+            if (ip < match_limit)
+            {
+                //the position just before the match end is a likely start of the next one
+                table[hash_sequence(read_u32(ip - 2))] = (uint32_t)(ip - 2 - in);
+            }
+        }
+    }
+    op = write_sequence(op, anchor, (uint64_t)(end - anchor), 0, 0);
+    return (uint64_t)(op - (uint8_t*)dst);
+}
+
+static inline bool read_length(const uint8_t** ip, const uint8_t* ip_end, uint64_t* length)
+{
+    uint8_t byte;
+    do
+    {
+        if (*ip >= ip_end)
+        {
+            return false;
+        }
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool decompress_block(const void* src, uint64_t src_size, void* dst, uint64_t dst_size)
+{
+    const uint8_t* ip     = (const uint8_t*)src;
+    const uint8_t* ip_end = ip + src_size;
+    uint8_t* op_start = (uint8_t*)dst;
+    uint8_t* op       = op_start;
+    uint8_t* op_end   = op + dst_size;
+
+    for (;;)
+    {
+        if (ip >= ip_end)
+        {
+            return false;
+        }
+        uint32_t token = *ip++;
+
+        uint64_t length = token >> 4;
+        if (length == 15 && !read_length(&ip, ip_end, &length))
+        {
+            return false;
+        }
+        if (length > (uint64_t)(ip_end - ip) || length > (uint64_t)(op_end - op))
+        {
+            return false;
+        }
+        memcpy(op, ip, length);
+        op += length;
+        ip += length;
+        if (ip == ip_end)
+        {
+            return op == op_end;
+        }
+
+        if (ip_end - ip < 2)
+        {
+            return false;
+        }
+        uint32_t offset = ip[0] | ((uint32_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint64_t)(op - op_start))
+        {
+            return false;
+        }
+        length = token & 15;
+        if (length == 15 && !read_length(&ip, ip_end, &length))
+        {
+            return false;
+        }
+        length += COMPRESS_MIN_MATCH;
+        if (length > (uint64_t)(op_end - op))
+        {
+            return false;
+        }
+
+        const uint8_t* match = op - offset;
+        uint8_t* copy_end = op + length;
+        if (offset >= 8 && (uint64_t)(op_end - op) >= length + 8)
+        {
+            //every 8 bytes come from at least 8 back, so they are already written even when it overlaps
+            do
+            {
+                memcpy(op, match, 8);
+                op += 8;
+                match += 8;
+            } while (op < copy_end);
+        }
+        else
+        {
+            //short offsets repeat a pattern, byte by byte
+            for (; op < copy_end; ++op, ++match)
+            {
+                *op = *match;
+            }
+        }
+        op = copy_end;
+    }
+}
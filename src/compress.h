@@ -0,0 +1,32 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdint.h>
+
+/*
+    Byte oriented LZ77 in the LZ4 block layout: every sequence is a token (literal count in the high
+    nibble, match length - COMPRESS_MIN_MATCH in the low one, 15 means more length bytes follow),
+    the literals, a 2 byte little endian offset back into what was already decoded and the match.
+    The last sequence only has literals. Nothing is entropy coded, so decoding is little more than
+    memcpy and runs at memory speed, which is what a load needs. Compression is a single greedy pass
+    over a hash table, meant for the asset baker.
+*/
+#define COMPRESS_MIN_MATCH     4
+#define COMPRESS_MAX_OFFSET    65535
+#define COMPRESS_HASH_BITS     14
+//a block ends in at least this many literals, and no match starts in its last COMPRESS_MATCH_LIMIT bytes
+#define COMPRESS_LAST_LITERALS 5
+#define COMPRESS_MATCH_LIMIT   12
+
+//worst case size of compress_block's output, for data that doesn't compress at all
+inline uint64_t compress_bound(uint64_t size)
+{
+    return size + size / 255 + 16;
+}
+
+//returns the compressed size, 0 if dst is smaller than compress_bound(size)
+uint64_t compress_block(const void* src, uint64_t size, void* dst, uint64_t dst_capacity);
+//false if src is damaged or doesn't decode to exactly dst_size bytes, never reads or writes out of bounds
+bool     decompress_block(const void* src, uint64_t src_size, void* dst, uint64_t dst_size);
+
+#endif
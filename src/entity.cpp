@@ -1,16 +1,15 @@
 #include "entity.h"
 #include "character.h"
 #include "world.h"
+#include "pool.h"
 
-static uint32_t unique_entity_id;
-static entity*  g_entity_storage;
-static uint32_t g_num_entities;
+static uint32_t     unique_entity_id;
+static pool<entity> g_entity_storage;
 
 void entities_init(void)
 {
     unique_entity_id = 1;
-    g_entity_storage = (entity*)push_size(MAX_NUM_STATIC_GEOMETRIES * sizeof(entity));
-    g_num_entities = 0;
+    pool_init(&g_entity_storage, get_game_memory_arena(), MAX_NUM_STATIC_GEOMETRIES);
 }
 
 uint32_t get_next_unique_entity_id(void)
@@ -31,8 +30,33 @@ box3 get_entity_bounds(entity* p_entity)
 
 entity* put_static_geometry_in_storage(entity* p_entity)
 {
-    printf("Storing static geometry...\n");
-    return NULL;
+    entity* result = pool_alloc(&g_entity_storage);
+    if (!result)
+    {
+        printf("Static geometry storage full\n");
+    }
+    return result;
+}
+
+static void destroy_static_geometry(entity* p_entity)
+{
+    remove_entity_from_world(p_entity);
+    release_entity_assets(p_entity);
+    //its slot goes back once the last load is done
+    release_asset_load(p_entity->m_asset);
+    p_entity->m_asset = 0;
+    p_entity->m_id = 0;
+    pool_free(&g_entity_storage, p_entity);
+}
+
+uint32_t get_num_static_geometries(void)
+{
+    return g_entity_storage.m_count;
+}
+
+entity* get_static_geometry_by_index(uint32_t index)
+{
+    return pool_get(&g_entity_storage, index);
 }
 
 void draw_entity(entity* p_entity)
@@ -68,4 +92,23 @@ entity* put_entity_in_storage(entity* p_entity)
             break;
     }
     return result;
+}
+
+void destroy_entity(entity* p_entity)
+{
+    switch (p_entity->m_type)
+    {
+        case(ET_CHARACTER):
+        {
+            destroy_character((character*)p_entity);
+            break;
+        }
+        case(ET_STATIC_GEOMETRY):
+        {
+            destroy_static_geometry(p_entity);
+            break;
+        }
+        default:
+            break;
+    }
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #define MAX_NUM_STATIC_GEOMETRIES 1024
 #define MAX_NUM_CHARACTERS        1024
 #define MAX_MESHES_PER_ENTITY     4
+#define CHARACTER_MEMORY_BUDGET   Megabytes(40)
 
 
 enum entity_type
@@ -31,6 +32,8 @@ struct entity
 {
     mesh*       m_meshes; 
     shader      s;
+    asset_handle m_asset; //latest streamed load, not drawn until it is ready
+    asset_id    m_model;  //shared meshes, released when the entity is destroyed
 
     uint32_t    m_num_meshes;
     uint32_t    m_id;
@@ -48,9 +51,12 @@ struct      world_chunk;
 
 void        draw_entity(entity* p_entity);
 entity*     put_entity_in_storage(entity* p_entity);
+void        destroy_entity(entity* p_entity);
 box3        get_entity_bounds(entity* p_entity);
 inline bool is_entity_alive(entity* p_entity) { return (p_entity->m_id != 0);}
 uint32_t    get_next_unique_entity_id(void);
 void        entities_init(void);
+uint32_t    get_num_static_geometries(void);
+entity*     get_static_geometry_by_index(uint32_t index);
 
 #endif
\ No newline at end of file
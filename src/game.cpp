@@ -19,6 +19,10 @@
 #include "camera.h"
 #include "thread.h"
 #include "character.h"
+#include "pack.h"
+#include "asset_stream.h"
+#include "asset_watch.h"
+#include "string_table.h"
 
 #include <stb/stb_image.h>
 
@@ -542,6 +546,60 @@ static void move_and_rotate_player_character(character* controlled_character, in
     }
 }
 
+struct pose_bones_job
+{
+    character* p_character;
+    float      dt;
+    float      blend_factor;
+};
+
+static void pose_bones(uint32_t begin, uint32_t end, void* arg)
+{
+    pose_bones_job* jobs = (pose_bones_job*)arg;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        get_bone_transforms(jobs[i].p_character, jobs[i].dt, 0, 1, jobs[i].blend_factor);
+    }
+}
+
+/*
+    Every character plays its animations with a state of its own, so the ones in the region are
+    gathered from its chunks and posed in parallel, one character is already worth a job. They are
+    only uploaded and drawn on the main thread, which helps posing while it waits.
+*/
+static void pose_characters(sim_region* region, float dt)
+{
+    uint32_t num_entities = 0;
+    for (uint32_t i = 0; i < region->num_chunks; ++i)
+    {
+        num_entities += region->chunks_to_simulate[i]->m_num_entities;
+    }
+    pose_bones_job* jobs = num_entities ? push_array<pose_bones_job>(get_frame_arena(), num_entities) : NULL;
+    if (!jobs)
+    {
+        return;
+    }
+
+    uint32_t num_jobs = 0;
+    for (uint32_t i = 0; i < region->num_chunks; ++i)
+    {
+        world_chunk* p_chunk = region->chunks_to_simulate[i];
+        for (uint32_t j = 0; j < p_chunk->m_num_entities; ++j)
+        {
+            entity* p_entity = p_chunk->m_entities[j];
+            if (!is_asset_ready(p_entity->m_asset))
+            {
+                continue;
+            }
+            pose_bones_job* job = jobs + num_jobs++;
+            job->p_character  = (character*)p_entity;
+            job->dt           = dt;
+            job->blend_factor = glm::clamp(glm::length(p_entity->m_dp) / 5.0f, 0.0f, 1.0f);
+        }
+    }
+    parallel_for(num_jobs, 1, &pose_bones, jobs);
+}
+
 static void simulate_and_render_game(input* inp, character* controlled_character, float dt)
 {
     //get world chunks covered by camera
@@ -567,6 +625,7 @@ static void simulate_and_render_game(input* inp, character* controlled_character
 
     //play animation
     float anim_time = g_pause ? 0 : dt;
+    pose_characters(&region, anim_time);
 
     for (uint32_t i = 0; i < region.num_chunks; ++i)
     {
@@ -574,6 +633,13 @@ static void simulate_and_render_game(input* inp, character* controlled_character
         for (uint32_t j = 0; j < p_chunk->m_num_entities; ++j)
         {
             entity* p_entity = p_chunk->m_entities[j];
+            if (!is_asset_ready(p_entity->m_asset))
+            {
+                //still streaming in, its collision rect stands in for it
+                glm::vec3 placeholder_color(0.5f, 0.5f, 0.5f);
+                draw_debug_rect(p_entity, g_debug_draw.s, placeholder_color);
+                continue;
+            }
             use_shader(p_entity->s);
             set_mat4(p_entity->s, "projection", projection);
             set_mat4(p_entity->s, "view", view);
@@ -584,8 +650,6 @@ static void simulate_and_render_game(input* inp, character* controlled_character
             model *= rotation_m;
             model = glm::scale(model, glm::vec3(0.02f, 0.02f, 0.02f));
             set_mat4(p_entity->s, "model", model);
-            float blend_factor = glm::clamp(glm::length(p_entity->m_dp) / 5.0f, 0.0f, 1.0f);
-            get_bone_transforms((character*)p_entity, anim_time,0,1, blend_factor);
             set_bone_transforms((character*)p_entity);
             draw_entity(p_entity);
         }
@@ -594,39 +658,68 @@ static void simulate_and_render_game(input* inp, character* controlled_character
     SDL_GL_SwapWindow(g_window);
 }
 
-void load_sounds()
+//sounds stored as they are in the pack are decoded straight from the mapping
+static Mix_Chunk* load_sound_effect(const char* path)
 {
-    //Load music
-    g_music = Mix_LoadMUS( "Assets/Sounds/beat.wav" );
-    if( g_music == NULL )
+    uint64_t size = 0;
+    const void* packed = pack_load(path, PACK_ENTRY_RAW, NULL, &size);
+    if (packed)
     {
-        printf( "Failed to load beat music! SDL_mixer Error: %s\n", Mix_GetError() );
+        //the chunk is decoded right away, a decompressed copy isn't needed afterwards
+        Mix_Chunk* result = Mix_LoadWAV_RW(SDL_RWFromConstMem(packed, (int)size), 1);
+        pack_free(packed);
+        return result;
     }
-    
-    //Load sound effects
-    g_scratch = Mix_LoadWAV( "Assets/Sounds/scratch.wav" );
-    if( g_scratch == NULL )
+    return Mix_LoadWAV(path);
+}
+
+static Mix_Music* load_music(const char* path)
+{
+    uint64_t size = 0;
+    const void* packed = pack_load(path, PACK_ENTRY_RAW, NULL, &size);
+    if (packed)
     {
-        printf( "Failed to load scratch sound effect! SDL_mixer Error: %s\n", Mix_GetError() );
+        //music streams from the rw while it plays, the pack stays mapped and a decompressed copy is kept until exit
+        return Mix_LoadMUS_RW(SDL_RWFromConstMem(packed, (int)size), 1);
     }
-    
-    g_high = Mix_LoadWAV( "Assets/Sounds/high.wav" );
-    if( g_high == NULL )
+    return Mix_LoadMUS(path);
+}
+
+//sounds are decoded on a job thread, the globals are only set on the main thread once they are ready
+static bool load_sound_effect_job(asset_load* load)
+{
+    load->m_result = load_sound_effect(load->m_path);
+    if (!load->m_result)
     {
-        printf( "Failed to load high sound effect! SDL_mixer Error: %s\n", Mix_GetError() );
+        printf( "Failed to load sound effect %s! SDL_mixer Error: %s\n", load->m_path, Mix_GetError() );
     }
+    return load->m_result != NULL;
+}
 
-    g_medium = Mix_LoadWAV( "Assets/Sounds/medium.wav" );
-    if( g_medium == NULL )
+static bool load_music_job(asset_load* load)
+{
+    load->m_result = load_music(load->m_path);
+    if (!load->m_result)
     {
-        printf( "Failed to load medium sound effect! SDL_mixer Error: %s\n", Mix_GetError() );
+        printf( "Failed to load music %s! SDL_mixer Error: %s\n", load->m_path, Mix_GetError() );
     }
+    return load->m_result != NULL;
+}
 
-    g_low = Mix_LoadWAV( "Assets/Sounds/low.wav" );
-    if( g_low == NULL )
-    {
-        printf( "Failed to load low sound effect! SDL_mixer Error: %s\n", Mix_GetError() );
-    }    
+static bool publish_sound(asset_load* load)
+{
+    *(void**)load->m_target = load->m_result;
+    return true;
+}
+
+void load_sounds()
+{
+    //playing a sound that isn't there yet is a no-op, nothing waits on the loads so they are let go right away
+    release_asset_load(begin_asset_load( "Assets/Sounds/beat.wav", &load_music_job, &publish_sound, &g_music, 0, 0 ));
+    release_asset_load(begin_asset_load( "Assets/Sounds/scratch.wav", &load_sound_effect_job, &publish_sound, &g_scratch, 0, 0 ));
+    release_asset_load(begin_asset_load( "Assets/Sounds/high.wav", &load_sound_effect_job, &publish_sound, &g_high, 0, 0 ));
+    release_asset_load(begin_asset_load( "Assets/Sounds/medium.wav", &load_sound_effect_job, &publish_sound, &g_medium, 0, 0 ));
+    release_asset_load(begin_asset_load( "Assets/Sounds/low.wav", &load_sound_effect_job, &publish_sound, &g_low, 0, 0 ));
 }
 
 struct character_info
@@ -698,18 +791,26 @@ int main(int argc, char* args[])
         printf( "Failed to initialize!\n" );
         return 1;
     }
+    uint64_t memory_init_start = SDL_GetPerformanceCounter();
     if (!game_memory_init())
     {
         printf("Can not allocate memory, quitting!\n");
         return 2;
     }
+    uint64_t memory_init_end = SDL_GetPerformanceCounter();
+    printf("Game memory init: %.3f ms\n", (double)(memory_init_end - memory_init_start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
 
     camera_init();
     world_init();
+    string_table_init();
     asset_storage_init();
+    //no pack is fine, everything is loaded from loose files then
+    pack_open(PACK_DEFAULT_PATH);
     entities_init();
     characters_init();
     mesh_component_init();
+    asset_stream_init();
+    asset_watch_init("Assets");
     debug_draw_init();
     job_system_init();
 
@@ -724,9 +825,14 @@ int main(int argc, char* args[])
     _player.m_rot = glm::quat(glm::vec3(0.0f, 0.0f, 0.0f));
     
     character* player = create_character(&_player);
-    load_model_from_file(player, "Assets/Meshes/Paladin/Sword_and_shield_idle.dae", 2);
-    load_animation_from_file(player, "Assets/Meshes/Paladin/Sword_and_shield_walk.dae");
+    //the player is drawn as a rect until both are in
+    load_model_async(player, "Assets/Meshes/Paladin/Sword_and_shield_idle.dae", 2);
+    load_animation_async(player, "Assets/Meshes/Paladin/Sword_and_shield_walk.dae");
     player->s = create_default_shader();
+    load_sounds();
+    print_game_memory_stats();
+    print_memory_arena_report();
+    print_asset_residency();
     /*
     character _obstacle;
     memset(&_obstacle, 0, sizeof(character));
@@ -734,7 +840,7 @@ int main(int argc, char* args[])
     _obstacle.m_p = {5, 0, 0};
     _obstacle.m_height = 2.0f;
     obstacle = create_character(&_obstacle);
-    load_model_from_file(obstacle, "Assets/Meshes/Skeletal_temp/Breakdance_1990.dae", 1);
+    load_model_async(obstacle, "Assets/Meshes/Skeletal_temp/Breakdance_1990.dae", 1);
     obstacle->s = player->s;
     */
 
@@ -745,7 +851,16 @@ int main(int argc, char* args[])
    
     while(g_running)
     {
+        begin_frame_memory();
         fill_game_memory();
+        //changed files are read on the job threads and swapped in by process_asset_loads
+        char changed_path[MAX_ASSET_PATH_LENGTH];
+        while (poll_asset_change(changed_path, sizeof(changed_path)))
+        {
+            reload_changed_asset(changed_path);
+        }
+        process_asset_loads(ASSET_UPLOAD_BUDGET_MS);
+        evict_unused_assets();
         input game_input = handle_input();
         float dt = frame_time * 0.001f; //seconds
         
@@ -765,5 +880,12 @@ int main(int argc, char* args[])
         last_time = current_time;
     }
 
+    print_game_memory_stats();
+    print_memory_arena_report();
+    print_asset_residency();
+#ifdef GAME_MEMORY_DEBUG
+    print_arena_allocation_sites(32);
+#endif
+
     return 0;
 }
\ No newline at end of file
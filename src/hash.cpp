@@ -1,5 +1,10 @@
 #include "hash.h"
 
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#pragma intrinsic(_umul128)
+#endif
+
 static inline uint32_t murmur_32_scramble(uint32_t k) {
     k *= 0xcc9e2d51;
     k = (k << 15) | (k >> 17);
@@ -39,4 +44,122 @@ uint32_t murmur3_32(const uint8_t* key, size_t len, uint32_t seed)
     h *= 0xc2b2ae35;
     h ^= h >> 16;
     return h;
-}
\ No newline at end of file
+}
+
+static inline void hash64_multiply(uint64_t* a, uint64_t* b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = *a;
+    r *= *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    *a = _umul128(*a, *b, b);
+#else
+    uint64_t a_lo = *a & 0xFFFFFFFF, a_hi = *a >> 32;
+    uint64_t b_lo = *b & 0xFFFFFFFF, b_hi = *b >> 32;
+    uint64_t lo_lo = a_lo * b_lo;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    *a = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+    *b = (hi_lo >> 32) + (cross >> 32) + a_hi * b_hi;
+#endif
+}
+
+static inline uint64_t hash64_mix(uint64_t a, uint64_t b)
+{
+    hash64_multiply(&a, &b);
+    return a ^ b;
+}
+
+//little endian loads, same as hash64_read_const on the platforms we ship
+static inline uint64_t hash64_read8(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash64_read4(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash64_inline(const uint8_t* p, size_t len, uint64_t seed)
+{
+    seed ^= hash64_mix(seed ^ hash64_secret[0], hash64_secret[1]);
+    uint64_t a, b;
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            a = (hash64_read4(p) << 32) | hash64_read4(p + ((len >> 3) << 2));
+            b = (hash64_read4(p + len - 4) << 32) | hash64_read4(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
+        {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        size_t i = len;
+        if (i > 48)
+        {
+            //three independent lanes so the multiplies overlap
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do
+            {
+                seed = hash64_mix(hash64_read8(p) ^ hash64_secret[1], hash64_read8(p + 8) ^ seed);
+                see1 = hash64_mix(hash64_read8(p + 16) ^ hash64_secret[2], hash64_read8(p + 24) ^ see1);
+                see2 = hash64_mix(hash64_read8(p + 32) ^ hash64_secret[3], hash64_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = hash64_mix(hash64_read8(p) ^ hash64_secret[1], hash64_read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = hash64_read8(p + i - 16);
+        b = hash64_read8(p + i - 8);
+    }
+    a ^= hash64_secret[1];
+    b ^= seed;
+    hash64_multiply(&a, &b);
+    return hash64_mix(a ^ hash64_secret[0] ^ len, b ^ hash64_secret[1]);
+}
+
+uint64_t hash64(const void* key, size_t len, uint64_t seed)
+{
+    return hash64_inline((const uint8_t*)key, len, seed);
+}
+
+#define HASH64_PREFETCH_DISTANCE 4
+
+void hash64_batch(const char* const* keys, const size_t* lengths, uint32_t count, uint64_t* out_hashes, uint64_t seed)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        //keys are usually scattered, start pulling the next ones in while this one hashes
+#if defined(__GNUC__) || defined(__clang__)
+        if (i + HASH64_PREFETCH_DISTANCE < count)
+        {
+            __builtin_prefetch(keys[i + HASH64_PREFETCH_DISTANCE]);
+        }
+#endif
+        out_hashes[i] = hash64_inline((const uint8_t*)keys[i], lengths[i], seed);
+    }
+}
@@ -5,7 +5,108 @@
 #include <stdint.h>
 
 #define  SEED 1234
+#define  HASH64_SEED 0x9E3779B97F4A7C15ULL
 
 uint32_t murmur3_32(const uint8_t* key, size_t len, uint32_t seed);
 
-#endif
\ No newline at end of file
+/*
+    64 bit hash built on wyhash (public domain), reads 16-48 bytes per step.
+    hash64_const gives the same result at compile time, so a literal can be hashed once and
+    compared against a runtime hash64 of the same bytes.
+*/
+uint64_t hash64(const void* key, size_t len, uint64_t seed = HASH64_SEED);
+//hashes count keys into out_hashes, cheaper than calling hash64 in a loop for lots of short keys
+void     hash64_batch(const char* const* keys, const size_t* lengths, uint32_t count, uint64_t* out_hashes, uint64_t seed = HASH64_SEED);
+
+static constexpr uint64_t hash64_secret[4] = {0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL};
+
+struct hash64_product
+{
+    uint64_t lo;
+    uint64_t hi;
+};
+
+//64x64 -> 128 bit multiply done in 32 bit halves
+constexpr hash64_product hash64_multiply_const(uint64_t a, uint64_t b)
+{
+    uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+    uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    hash64_product result = {(cross << 32) | (lo_lo & 0xFFFFFFFF), (hi_lo >> 32) + (cross >> 32) + a_hi * b_hi};
+    return result;
+}
+
+constexpr uint64_t hash64_mix_const(uint64_t a, uint64_t b)
+{
+    hash64_product product = hash64_multiply_const(a, b);
+    return product.lo ^ product.hi;
+}
+
+constexpr uint64_t hash64_read_const(const char* p, uint32_t num_bytes)
+{
+    uint64_t result = 0;
+    for (uint32_t i = 0; i < num_bytes; ++i)
+    {
+        result |= (uint64_t)(uint8_t)p[i] << (8 * i);
+    }
+    return result;
+}
+
+constexpr uint64_t hash64_const(const char* p, size_t len, uint64_t seed = HASH64_SEED)
+{
+    seed ^= hash64_mix_const(seed ^ hash64_secret[0], hash64_secret[1]);
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            a = (hash64_read_const(p, 4) << 32) | hash64_read_const(p + ((len >> 3) << 2), 4);
+            b = (hash64_read_const(p + len - 4, 4) << 32) | hash64_read_const(p + len - 4 - ((len >> 3) << 2), 4);
+        }
+        else if (len > 0)
+        {
+            a = ((uint64_t)(uint8_t)p[0] << 16) | ((uint64_t)(uint8_t)p[len >> 1] << 8) | (uint8_t)p[len - 1];
+        }
+    }
+    else
+    {
+        size_t i = len;
+        if (i > 48)
+        {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do
+            {
+                seed = hash64_mix_const(hash64_read_const(p, 8) ^ hash64_secret[1], hash64_read_const(p + 8, 8) ^ seed);
+                see1 = hash64_mix_const(hash64_read_const(p + 16, 8) ^ hash64_secret[2], hash64_read_const(p + 24, 8) ^ see1);
+                see2 = hash64_mix_const(hash64_read_const(p + 32, 8) ^ hash64_secret[3], hash64_read_const(p + 40, 8) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = hash64_mix_const(hash64_read_const(p, 8) ^ hash64_secret[1], hash64_read_const(p + 8, 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = hash64_read_const(p + i - 16, 8);
+        b = hash64_read_const(p + i - 8, 8);
+    }
+    hash64_product product = hash64_multiply_const(a ^ hash64_secret[1], b ^ seed);
+    return hash64_mix_const(product.lo ^ hash64_secret[0] ^ len, product.hi ^ hash64_secret[1]);
+}
+
+//hash64_literal("Assets/foo.png") == hash64("Assets/foo.png", strlen("Assets/foo.png"))
+template<size_t N>
+constexpr uint64_t hash64_literal(const char (&str)[N])
+{
+    return hash64_const(str, N - 1);
+}
+
+#endif
@@ -1,42 +1,948 @@
 #include "memory.h"
+#include "common.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <SDL_mutex.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
 
 static memory_arena game_memory;
+static memory_arena frame_arenas[2];
+static uint32_t     frame_index;
+static memory_arena sub_arenas[MAX_NUM_SUB_ARENAS];
+static uint32_t     num_sub_arenas;
+
+//each thread that runs jobs owns one of these, nobody else pushes into it
+struct thread_memory
+{
+    memory_arena permanent;   //refilled with new blocks from the thread region
+    memory_arena transient;   //reset the first time it is used in a new frame
+    uint32_t     frame_index;
+    char         name[2][16];
+};
+
+static memory_arena               thread_region;
+static std::atomic<uint64_t>      thread_region_cursor;
+static thread_memory              thread_memories[MAX_NUM_THREAD_ARENAS];
+static uint32_t                   num_thread_memories;
+static std::atomic<uint32_t>      memory_frame_counter;
+static thread_local thread_memory* tls_thread_memory;
+
+//at the start of every block of a freeable arena, the arena's data starts BLOCK_HEADER_SIZE in
+struct memory_block
+{
+    memory_block* prev; //previous block of the same arena, or the next one on the free list
+    uint64_t      size; //header included
+};
+
+#ifdef GAME_MEMORY_GUARD_PAGES
+#define BLOCK_HEADER_SIZE ARENA_PAGE_SIZE
+#else
+#define BLOCK_HEADER_SIZE CACHE_LINE_SIZE
+#endif
+
+static memory_arena      block_region;
+static memory_block*     free_blocks;
+static uint64_t          free_block_bytes;
+static SDL_mutex*        block_mutex;
+
+#ifdef GAME_MEMORY_DEBUG
+struct arena_allocation_record
+{
+    const char* file;
+    const char* arena_name;
+    uint8_t*    address;
+    uint64_t    size;
+    uint32_t    line;
+    uint32_t    prev; //previous record of the same arena
+    bool        live;
+};
+
+struct allocation_site
+{
+    const char* file;
+    uint32_t    line;
+    uint32_t    count;
+    uint64_t    bytes;
+};
+
+#define MAX_NUM_ALLOCATION_SITES 1024
+
+//record 0 is never handed out so 0 can mean "no record"
+static arena_allocation_record* debug_records;
+static std::atomic<uint32_t>    num_debug_records;
+#endif
+
+#if defined(GAME_MEMORY_DEBUG) && !defined(GAME_MEMORY_GUARD_PAGES)
+#define ARENA_DEBUG_TRAILER_SIZE ARENA_CANARY_SIZE
+#else
+#define ARENA_DEBUG_TRAILER_SIZE 0
+#endif
+
+static inline uint64_t round_up_to_page(uint64_t size)
+{
+    return ((size + ARENA_PAGE_SIZE - 1) / ARENA_PAGE_SIZE) * ARENA_PAGE_SIZE;
+}
+
+/*
+    The arena is reserved as one contiguous range of address space and committed lazily in
+    GAME_MEMORY_COMMIT_STEP chunks, so RSS follows what the game actually pushes instead of the cap.
+*/
+static void* platform_reserve_memory(uint64_t size)
+{
+#ifdef _WIN32
+    return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void* result = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (result == MAP_FAILED)
+    {
+        return NULL;
+    }
+#if defined(GAME_MEMORY_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+    madvise(result, size, MADV_HUGEPAGE);
+#endif
+    return result;
+#endif
+}
+
+static bool platform_commit_memory(void* address, uint64_t size)
+{
+#ifdef _WIN32
+    return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+//the range stays reserved, its pages read back as zero once committed again
+static void platform_decommit_memory(void* address, uint64_t size)
+{
+#ifdef _WIN32
+    VirtualFree(address, size, MEM_DECOMMIT);
+#else
+    madvise(address, size, MADV_DONTNEED);
+#endif
+}
+
+#ifdef GAME_MEMORY_GUARD_PAGES
+static bool platform_protect_memory(void* address, uint64_t size)
+{
+#ifdef _WIN32
+    DWORD old_protect;
+    return VirtualProtect(address, size, PAGE_NOACCESS, &old_protect) != 0;
+#else
+    return mprotect(address, size, PROT_NONE) == 0;
+#endif
+}
+#endif
+
+static bool commit_arena_memory(memory_arena* arena, uint64_t required)
+{
+    if (required > arena->capacity)
+    {
+        printf("Arena %s out of memory: %llu bytes requested, budget is %llu\n", arena->name,
+               (unsigned long long)required, (unsigned long long)arena->capacity);
+        return false;
+    }
+
+    //round up to the next commit step, clamped to the reserved range
+    uint64_t new_committed = ((required + GAME_MEMORY_COMMIT_STEP - 1) / GAME_MEMORY_COMMIT_STEP) * GAME_MEMORY_COMMIT_STEP;
+    if (new_committed > arena->capacity)
+    {
+        new_committed = arena->capacity;
+    }
+
+    //the range below used can belong to a sub arena that commits its own pages, skip it
+    uint64_t commit_start = (arena->used / ARENA_PAGE_SIZE) * ARENA_PAGE_SIZE;
+    if (commit_start < arena->committed)
+    {
+        commit_start = arena->committed;
+    }
+
+    if (!platform_commit_memory(arena->base + commit_start, new_committed - commit_start))
+    {
+        printf("Failed to commit arena memory\n");
+        return false;
+    }
+    arena->committed = new_committed;
+    return true;
+}
+
+static uint64_t get_alignment_offset(memory_arena* arena, uint64_t alignment)
+{
+    uintptr_t current = (uintptr_t)(arena->base + arena->used);
+    uintptr_t mask    = (uintptr_t)alignment - 1;
+    uint64_t  offset  = 0;
+    if (current & mask)
+    {
+        offset = alignment - (current & mask);
+    }
+    return offset;
+}
+
+/*
+    Sub arenas only take address space from the parent, they commit their own pages as they grow.
+    The budget is rounded up to whole pages so commits never touch a neighbour's pages.
+*/
+static bool init_sub_arena(memory_arena* arena, memory_arena* parent, const char* name, uint64_t budget)
+{
+    uint64_t size = round_up_to_page(budget);
+    uint64_t offset = get_alignment_offset(parent, ARENA_PAGE_SIZE);
+    if (parent->used + offset + size > parent->capacity)
+    {
+        printf("Can not carve arena %s (%llu bytes) out of %s\n", name, (unsigned long long)size, parent->name);
+        return false;
+    }
+
+    memset(arena, 0, sizeof(memory_arena));
+    arena->name     = name;
+    arena->base     = parent->base + parent->used + offset;
+    arena->capacity = size;
+
+    parent->used += offset + size;
+    parent->num_allocations++;
+    if (parent->used > parent->high_water)
+    {
+        parent->high_water = parent->used;
+    }
+    return true;
+}
 
 bool game_memory_init(void)
 {
-    uint64_t memory_size = 4LL*1024LL*1024LL*1024LL;
-    game_memory.base = (uint8_t*)malloc(memory_size);
+#ifdef GAME_MEMORY_DEBUG
+    //records live outside the arenas so tracking doesn't show up in the numbers it reports
+    uint64_t records_size = ARENA_MAX_DEBUG_RECORDS * sizeof(arena_allocation_record);
+    debug_records = (arena_allocation_record*)platform_reserve_memory(records_size);
+    if (!debug_records || !platform_commit_memory(debug_records, records_size))
+    {
+        return false;
+    }
+    num_debug_records = 1;
+#endif
+
+    uint64_t memory_size = GAME_MEMORY_RESERVE_SIZE;
+    game_memory.base = (uint8_t*)platform_reserve_memory(memory_size);
     if (!game_memory.base)
     {
         return false;
     }
+    game_memory.name = "permanent";
     game_memory.capacity = memory_size;
     game_memory.used = 0;
-    memset(game_memory.base, 0, memory_size);
+    game_memory.committed = 0;
+    //freshly committed pages come back zeroed from the OS, no need to touch them here
+    if (!commit_arena_memory(&game_memory, GAME_MEMORY_COMMIT_STEP))
+    {
+        return false;
+    }
+
+    static const char* frame_arena_names[] = { "frame 0", "frame 1" };
+    for (uint32_t i = 0; i < array_count(frame_arenas); ++i)
+    {
+        if (!init_sub_arena(frame_arenas + i, &game_memory, frame_arena_names[i], FRAME_MEMORY_SIZE))
+        {
+            return false;
+        }
+    }
+    frame_index = 0;
+    num_sub_arenas = 0;
     return true;
 }
 
-void* push_size(uint64_t size)
+/*
+    Blocks are handed out from the thread region with a single atomic add, so worker threads
+    never take a lock and never touch the main arena's bump pointer.
+*/
+static uint8_t* grab_thread_block(uint64_t size)
+{
+    size = round_up_to_page(size);
+    //only moves the cursor when the block fits, a grab that fails leaves room for smaller ones
+    uint64_t offset = thread_region_cursor.load();
+    do
+    {
+        if (offset + size > thread_region.capacity)
+        {
+            printf("Thread memory region out of memory\n");
+            return NULL;
+        }
+    } while (!thread_region_cursor.compare_exchange_weak(offset, offset + size));
+
+    uint8_t* result = thread_region.base + offset;
+    if (!platform_commit_memory(result, size))
+    {
+        printf("Failed to commit thread memory\n");
+        return NULL;
+    }
+    return result;
+}
+
+static bool refill_thread_arena(memory_arena* arena, uint64_t min_size)
+{
+    uint64_t size  = min_size > arena->block_size ? min_size : arena->block_size;
+    size = round_up_to_page(size);
+    uint8_t* block = grab_thread_block(size);
+    if (!block)
+    {
+        return false;
+    }
+    //the rest of the old block is abandoned
+    arena->base      = block;
+    arena->used      = 0;
+    arena->committed = size;
+    arena->capacity  = size;
+    return true;
+}
+
+static void lock_blocks(void)
+{
+    SDL_LockMutex(block_mutex);
+}
+
+static void unlock_blocks(void)
 {
-    //round up to word aligned?
-    void* result = (void*)game_memory.base;
-    game_memory.base += size;
-    game_memory.used += size;
+    SDL_UnlockMutex(block_mutex);
+}
+
+/*
+    Best fit from the free list so a small arena doesn't take a big block another one needs, fresh
+    address space from the region when nothing there is big enough.
+*/
+static memory_block* grab_freeable_block(uint64_t size)
+{
+    lock_blocks();
+    memory_block** best = NULL;
+    for (memory_block** link = &free_blocks; *link; link = &(*link)->prev)
+    {
+        if ((*link)->size >= size && (!best || (*link)->size < (*best)->size))
+        {
+            best = link;
+            if ((*link)->size == size)
+            {
+                break;
+            }
+        }
+    }
+    memory_block* result = best ? *best : NULL;
+    uint64_t block_size = size;
+    if (result)
+    {
+        *best = result->prev;
+        block_size = result->size;
+        free_block_bytes -= block_size;
+    }
+    else if (block_region.used + size <= block_region.capacity)
+    {
+        //not committed yet, nothing can be written to it before the commit below
+        result = (memory_block*)(block_region.base + block_region.used);
+        block_region.used += size;
+        if (block_region.used > block_region.high_water)
+        {
+            block_region.high_water = block_region.used;
+        }
+    }
+    unlock_blocks();
+
+    if (!result)
+    {
+        printf("Block memory region out of memory\n");
+        return NULL;
+    }
+    if (!platform_commit_memory(result, block_size))
+    {
+        printf("Failed to commit block memory\n");
+        return NULL;
+    }
+    //everything past the first page was decommitted and comes back zeroed, clear the rest too
+    memset(result, 0, block_size < ARENA_PAGE_SIZE ? block_size : ARENA_PAGE_SIZE);
+    result->size = block_size;
     return result;
 }
 
+static bool refill_freeable_arena(memory_arena* arena, uint64_t min_size)
+{
+    uint64_t size = min_size + BLOCK_HEADER_SIZE;
+    size = round_up_to_page(size > arena->block_size ? size : arena->block_size);
+    memory_block* block = grab_freeable_block(size);
+    if (!block)
+    {
+        return false;
+    }
+    block->prev       = (memory_block*)arena->last_block;
+    arena->last_block = (uint8_t*)block;
+    //the rest of the old block is abandoned until the arena is released
+    arena->base      = (uint8_t*)block + BLOCK_HEADER_SIZE;
+    arena->used      = 0;
+    arena->committed = block->size - BLOCK_HEADER_SIZE;
+    arena->capacity  = block->size - BLOCK_HEADER_SIZE;
+    return true;
+}
+
+//returns the offset from the current top to the allocation, and the new top in required
+static uint64_t get_push_offset(memory_arena* arena, uint64_t size, uint64_t alignment, uint64_t* required)
+{
+#ifdef GAME_MEMORY_GUARD_PAGES
+    //end the allocation right where the guard page after it starts
+    uint64_t  start      = round_up_to_page(arena->used);
+    uint64_t  data_bytes = round_up_to_page(size);
+    uintptr_t end        = (uintptr_t)(arena->base + start + data_bytes);
+    uintptr_t result     = (end - size) & ~((uintptr_t)alignment - 1);
+    *required = start + data_bytes + ARENA_PAGE_SIZE;
+    return (uint64_t)(result - (uintptr_t)(arena->base + arena->used));
+#else
+    uint64_t offset = get_alignment_offset(arena, alignment);
+    *required = arena->used + offset + size + ARENA_DEBUG_TRAILER_SIZE;
+    return offset;
+#endif
+}
+
+//worst case space a push needs in a fresh, page aligned block
+static uint64_t get_push_footprint(uint64_t size, uint64_t alignment)
+{
+#ifdef GAME_MEMORY_GUARD_PAGES
+    return round_up_to_page(size) + ARENA_PAGE_SIZE;
+#else
+    return size + alignment + ARENA_DEBUG_TRAILER_SIZE;
+#endif
+}
+
+#ifdef GAME_MEMORY_DEBUG
+static void check_allocation_canary(arena_allocation_record* record)
+{
+#ifndef GAME_MEMORY_GUARD_PAGES
+    uint8_t* canary = record->address + record->size;
+    for (uint32_t i = 0; i < ARENA_CANARY_SIZE; ++i)
+    {
+        if (canary[i] != ARENA_CANARY_BYTE)
+        {
+            printf("Arena overrun: %llu byte allocation from %s:%u in arena %s\n",
+                   (unsigned long long)record->size, record->file, record->line, record->arena_name);
+            assert(0);
+            return;
+        }
+    }
+#endif
+}
+
+static void track_allocation(memory_arena* arena, uint8_t* address, uint64_t size, uint64_t required ARENA_SITE_DECL)
+{
+#ifdef GAME_MEMORY_GUARD_PAGES
+    if (!platform_protect_memory(arena->base + required - ARENA_PAGE_SIZE, ARENA_PAGE_SIZE))
+    {
+        printf("Failed to protect guard page\n");
+    }
+#else
+    memset(address + size, ARENA_CANARY_BYTE, ARENA_CANARY_SIZE);
+#endif
+
+    uint32_t index = num_debug_records.fetch_add(1);
+    if (index >= ARENA_MAX_DEBUG_RECORDS)
+    {
+        //table is full, the allocation still works but is not tracked
+        return;
+    }
+    arena_allocation_record* record = debug_records + index;
+    record->file       = file;
+    record->line       = line;
+    record->arena_name = arena->name;
+    record->address    = address;
+    record->size       = size;
+    record->prev       = arena->debug_record_head;
+    record->live       = true;
+    arena->debug_record_head = index;
+}
+#endif
+
+/*
+    Every rewind goes through here. In debug builds the canaries of the released allocations are
+    checked one last time and the memory is poisoned, so stale pointers into it read garbage.
+*/
+static void rewind_arena(memory_arena* arena, uint64_t new_used)
+{
+    assert(new_used <= arena->used);
+#ifdef GAME_MEMORY_DEBUG
+    uint8_t* new_top = arena->base + new_used;
+    while (arena->debug_record_head)
+    {
+        arena_allocation_record* record = debug_records + arena->debug_record_head;
+        if (record->address < new_top)
+        {
+            break;
+        }
+        check_allocation_canary(record);
+        record->live = false;
+        arena->debug_record_head = record->prev;
+    }
+
+#ifdef GAME_MEMORY_GUARD_PAGES
+    //guard pages in the released range have to become writable again before they get reused
+    uint64_t page_start = (new_used / ARENA_PAGE_SIZE) * ARENA_PAGE_SIZE;
+    uint64_t page_end   = round_up_to_page(arena->used);
+    if (page_end > arena->committed)
+    {
+        page_end = arena->committed;
+    }
+    if (page_end > page_start)
+    {
+        platform_commit_memory(arena->base + page_start, page_end - page_start);
+    }
+#endif
+    memset(arena->base + new_used, ARENA_POISON_BYTE, arena->used - new_used);
+#endif
+    arena->used = new_used;
+}
+
+void check_arena_canaries(memory_arena* arena)
+{
+#ifdef GAME_MEMORY_DEBUG
+    for (uint32_t index = arena->debug_record_head; index; index = debug_records[index].prev)
+    {
+        check_allocation_canary(debug_records + index);
+    }
+#endif
+}
+
+void* push_size(memory_arena* arena, uint64_t size, uint64_t alignment ARENA_SITE_DECL)
+{
+    //alignment has to be a power of two
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    uint64_t required;
+    uint64_t offset = get_push_offset(arena, size, alignment, &required);
+    if (required > arena->committed)
+    {
+        if (arena->block_size)
+        {
+            uint64_t footprint = get_push_footprint(size, alignment);
+            bool refilled = arena->freeable ? refill_freeable_arena(arena, footprint) : refill_thread_arena(arena, footprint);
+            if (!refilled)
+            {
+                return NULL;
+            }
+            offset = get_push_offset(arena, size, alignment, &required);
+        }
+        else if (!commit_arena_memory(arena, required))
+        {
+            return NULL;
+        }
+    }
+    void* result = (void*)(arena->base + arena->used + offset);
+#ifdef GAME_MEMORY_DEBUG
+    track_allocation(arena, (uint8_t*)result, size, required ARENA_SITE_ARGS);
+#endif
+    arena->used = required;
+    arena->num_allocations++;
+    if (arena->used > arena->high_water)
+    {
+        arena->high_water = arena->used;
+    }
+
+    assert_aligned(result, alignment);
+    return result;
+}
+
+void* push_size(uint64_t size, uint64_t alignment ARENA_SITE_DECL)
+{
+    return push_size(&game_memory, size, alignment ARENA_SITE_ARGS);
+}
+
 void  free_size(uint64_t size)
 {
-    game_memory.base -= size;
-    game_memory.used -= size;
+    rewind_arena(&game_memory, game_memory.used - size);
+}
+
+memory_arena* get_game_memory_arena(void)
+{
+    return &game_memory;
+}
+
+memory_arena* create_sub_arena(const char* name, uint64_t budget)
+{
+    if (num_sub_arenas == MAX_NUM_SUB_ARENAS)
+    {
+        printf("Maximum number of sub arenas reached, can not create %s\n", name);
+        return NULL;
+    }
+
+    memory_arena* result = sub_arenas + num_sub_arenas;
+    if (!init_sub_arena(result, &game_memory, name, budget))
+    {
+        return NULL;
+    }
+    num_sub_arenas++;
+    return result;
+}
+
+temporary_memory begin_temporary_memory(memory_arena* arena)
+{
+    temporary_memory result;
+    result.arena = arena;
+    result.base  = arena->base;
+    result.used  = arena->used;
+    arena->temp_count++;
+    return result;
+}
+
+void end_temporary_memory(temporary_memory temp)
+{
+    memory_arena* arena = temp.arena;
+    //scopes have to be closed in the reverse order they were opened
+    assert(arena->base != temp.base || arena->used >= temp.used);
+    assert(arena->temp_count > 0);
+    //a block arena that moved on only pushed this scope's data into the new block
+    rewind_arena(arena, arena->base == temp.base ? temp.used : 0);
+    arena->temp_count--;
+}
+
+void keep_temporary_memory(temporary_memory temp)
+{
+    assert(temp.arena->base != temp.base || temp.arena->used >= temp.used);
+    assert(temp.arena->temp_count > 0);
+    temp.arena->temp_count--;
+}
+
+/*
+    Two frame arenas are flipped every frame, so anything pushed last frame stays valid for one more
+    frame (e.g. for comparing against the previous frame's results) before it gets overwritten.
+*/
+void begin_frame_memory(void)
+{
+    frame_index = (frame_index + 1) % array_count(frame_arenas);
+    memory_arena* arena = frame_arenas + frame_index;
+    //a temporary scope left open across frames is a bug
+    assert(arena->temp_count == 0);
+    rewind_arena(arena, 0);
+
+#ifdef GAME_MEMORY_DEBUG
+    //catch overruns in long lived allocations once a frame instead of when they get rewound
+    check_arena_canaries(&game_memory);
+    check_arena_canaries(get_previous_frame_arena());
+    for (uint32_t i = 0; i < num_sub_arenas; ++i)
+    {
+        check_arena_canaries(sub_arenas + i);
+    }
+#endif
+
+    //thread transient arenas reset themselves once they see the new frame
+    memory_frame_counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+memory_arena* get_frame_arena(void)
+{
+    return frame_arenas + frame_index;
+}
+
+memory_arena* get_previous_frame_arena(void)
+{
+    return frame_arenas + ((frame_index + array_count(frame_arenas) - 1) % array_count(frame_arenas));
+}
+
+bool thread_memory_init(uint32_t num_threads)
+{
+    if (num_threads > MAX_NUM_THREAD_ARENAS)
+    {
+        printf("Too many threads for thread memory: %u\n", num_threads);
+        return false;
+    }
+    if (!init_sub_arena(&thread_region, &game_memory, "threads", THREAD_MEMORY_BUDGET))
+    {
+        return false;
+    }
+    thread_region_cursor = 0;
+
+    for (uint32_t i = 0; i < num_threads; ++i)
+    {
+        thread_memory* p_memory = thread_memories + i;
+        memset(p_memory, 0, sizeof(thread_memory));
+        snprintf(p_memory->name[0], sizeof(p_memory->name[0]), "thread %u", i);
+        snprintf(p_memory->name[1], sizeof(p_memory->name[1]), "thread %u tmp", i);
+
+        p_memory->permanent.name       = p_memory->name[0];
+        p_memory->permanent.block_size = THREAD_ARENA_BLOCK_SIZE;
+
+        p_memory->transient.name      = p_memory->name[1];
+        p_memory->transient.base      = grab_thread_block(THREAD_TRANSIENT_SIZE);
+        p_memory->transient.committed = THREAD_TRANSIENT_SIZE;
+        p_memory->transient.capacity  = THREAD_TRANSIENT_SIZE;
+        if (!p_memory->transient.base)
+        {
+            return false;
+        }
+    }
+    num_thread_memories = num_threads;
+    return true;
+}
+
+void attach_thread_memory(uint32_t thread_index)
+{
+    assert(thread_index < num_thread_memories);
+    tls_thread_memory = thread_memories + thread_index;
+    tls_thread_memory->frame_index = memory_frame_counter.load();
+}
+
+memory_arena* get_thread_arena(void)
+{
+    assert(tls_thread_memory);
+    return &tls_thread_memory->permanent;
+}
+
+memory_arena* get_thread_transient_arena(void)
+{
+    assert(tls_thread_memory);
+    thread_memory* p_memory = tls_thread_memory;
+    uint32_t frame = memory_frame_counter.load(std::memory_order_relaxed);
+    //a job that is still inside a temporary scope keeps its scratch until the scope closes
+    if (p_memory->frame_index != frame && p_memory->transient.temp_count == 0)
+    {
+        //first use this frame, whatever was pushed last frame is gone now
+        rewind_arena(&p_memory->transient, 0);
+        p_memory->frame_index = frame;
+    }
+    return &p_memory->transient;
+}
+
+memory_arena* get_scratch_arena(void)
+{
+    if (tls_thread_memory)
+    {
+        return get_thread_transient_arena();
+    }
+    return get_frame_arena();
+}
+
+bool block_memory_init(void)
+{
+    if (!init_sub_arena(&block_region, &game_memory, "blocks", BLOCK_MEMORY_BUDGET))
+    {
+        return false;
+    }
+    block_mutex = SDL_CreateMutex();
+    if (!block_mutex)
+    {
+        printf("Failed to create the block memory mutex\n");
+        return false;
+    }
+    free_blocks      = NULL;
+    free_block_bytes = 0;
+    return true;
+}
+
+void init_freeable_arena(memory_arena* arena, const char* name)
+{
+    memset(arena, 0, sizeof(memory_arena));
+    arena->name       = name;
+    arena->block_size = FREEABLE_ARENA_BLOCK_SIZE;
+    arena->freeable   = true;
+}
+
+/*
+    Blocks keep their first page committed for the free list link, the rest goes back to the OS so
+    an evicted asset really gives its memory back.
+*/
+void release_freeable_arena(memory_arena* arena)
+{
+    assert(arena->freeable && arena->temp_count == 0);
+#ifdef GAME_MEMORY_DEBUG
+    while (arena->debug_record_head)
+    {
+        arena_allocation_record* record = debug_records + arena->debug_record_head;
+        check_allocation_canary(record);
+        record->live = false;
+        arena->debug_record_head = record->prev;
+    }
+#endif
+
+    memory_block* block = (memory_block*)arena->last_block;
+    while (block)
+    {
+        memory_block* prev = block->prev;
+        if (block->size > ARENA_PAGE_SIZE)
+        {
+            platform_decommit_memory((uint8_t*)block + ARENA_PAGE_SIZE, block->size - ARENA_PAGE_SIZE);
+        }
+
+        lock_blocks();
+        block->prev = free_blocks;
+        free_blocks = block;
+        free_block_bytes += block->size;
+        unlock_blocks();
+        block = prev;
+    }
+
+    const char* name = arena->name;
+    init_freeable_arena(arena, name);
+}
+
+uint64_t get_freeable_arena_size(memory_arena* arena)
+{
+    uint64_t result = 0;
+    for (memory_block* block = (memory_block*)arena->last_block; block; block = block->prev)
+    {
+        result += block->size;
+    }
+    return result;
 }
 
 void fill_game_memory(void)
 {
-    if(!game_memory.initialized)
+    if(!game_memory.initialized && game_memory.committed > game_memory.used)
     {
-        uint64_t remaining = game_memory.capacity - game_memory.used;
-        memset(game_memory.base, 0, remaining);
+        uint64_t remaining = game_memory.committed - game_memory.used;
+        memset(game_memory.base + game_memory.used, 0, remaining);
         game_memory.initialized = true;
     }
+}
+
+static uint64_t get_peak_resident_memory(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return (uint64_t)counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        //ru_maxrss is in kilobytes on linux
+        return (uint64_t)usage.ru_maxrss * 1024;
+    }
+    return 0;
+#endif
+}
+
+void print_game_memory_stats(void)
+{
+    printf("Game memory: reserved %llu MB, committed %llu MB, used %llu KB, peak RSS %llu MB\n",
+           (unsigned long long)(game_memory.capacity / Megabytes(1)),
+           (unsigned long long)(game_memory.committed / Megabytes(1)),
+           (unsigned long long)(game_memory.used / Kilobytes(1)),
+           (unsigned long long)(get_peak_resident_memory() / Megabytes(1)));
+}
+
+static void print_arena_line(memory_arena* arena)
+{
+    printf("%-12s %10llu %10llu %10llu %10llu %8u\n", arena->name,
+           (unsigned long long)(arena->used / Kilobytes(1)),
+           (unsigned long long)(arena->high_water / Kilobytes(1)),
+           (unsigned long long)(arena->committed / Kilobytes(1)),
+           (unsigned long long)(arena->capacity / Kilobytes(1)),
+           arena->num_allocations);
+}
+
+void print_memory_arena_report(void)
+{
+    printf("%-12s %10s %10s %10s %10s %8s\n", "arena", "used KB", "peak KB", "commit KB", "budget KB", "allocs");
+    print_arena_line(&game_memory);
+    for (uint32_t i = 0; i < array_count(frame_arenas); ++i)
+    {
+        print_arena_line(frame_arenas + i);
+    }
+    for (uint32_t i = 0; i < num_sub_arenas; ++i)
+    {
+        print_arena_line(sub_arenas + i);
+    }
+    if (block_region.base)
+    {
+        //in use is what the region handed out minus what sits on the free list
+        lock_blocks();
+        block_region.committed = block_region.used;
+        memory_arena blocks = block_region;
+        blocks.used -= free_block_bytes;
+        unlock_blocks();
+        print_arena_line(&blocks);
+    }
+    if (num_thread_memories)
+    {
+        uint64_t cursor = thread_region_cursor.load();
+        thread_region.used = cursor < thread_region.capacity ? cursor : thread_region.capacity;
+        thread_region.high_water = thread_region.used;
+        print_arena_line(&thread_region);
+        for (uint32_t i = 0; i < num_thread_memories; ++i)
+        {
+            print_arena_line(&thread_memories[i].permanent);
+            print_arena_line(&thread_memories[i].transient);
+        }
+    }
+}
+
+#ifdef GAME_MEMORY_DEBUG
+static int compare_allocation_sites(const void* a, const void* b)
+{
+    const allocation_site* site_a = (const allocation_site*)a;
+    const allocation_site* site_b = (const allocation_site*)b;
+    if (site_a->bytes == site_b->bytes)
+    {
+        return 0;
+    }
+    return site_a->bytes < site_b->bytes ? 1 : -1;
+}
+#endif
+
+//live allocations grouped by call site, biggest first
+void print_arena_allocation_sites(uint32_t max_sites)
+{
+#ifdef GAME_MEMORY_DEBUG
+    static allocation_site sites[MAX_NUM_ALLOCATION_SITES];
+    uint32_t num_sites = 0;
+
+    uint32_t num_records = num_debug_records.load();
+    if (num_records > ARENA_MAX_DEBUG_RECORDS)
+    {
+        num_records = ARENA_MAX_DEBUG_RECORDS;
+    }
+
+    for (uint32_t i = 1; i < num_records; ++i)
+    {
+        arena_allocation_record* record = debug_records + i;
+        if (!record->live)
+        {
+            continue;
+        }
+
+        uint32_t site = 0;
+        for (; site < num_sites; ++site)
+        {
+            if (sites[site].line == record->line && strcmp(sites[site].file, record->file) == 0)
+            {
+                break;
+            }
+        }
+        if (site == num_sites)
+        {
+            if (num_sites == MAX_NUM_ALLOCATION_SITES)
+            {
+                continue;
+            }
+            sites[num_sites].file  = record->file;
+            sites[num_sites].line  = record->line;
+            sites[num_sites].count = 0;
+            sites[num_sites].bytes = 0;
+            num_sites++;
+        }
+        sites[site].count++;
+        sites[site].bytes += record->size;
+    }
+
+    qsort(sites, num_sites, sizeof(allocation_site), compare_allocation_sites);
+
+    printf("%10s %8s  %s\n", "live KB", "allocs", "call site");
+    for (uint32_t i = 0; i < num_sites && i < max_sites; ++i)
+    {
+        printf("%10llu %8u  %s:%u\n", (unsigned long long)(sites[i].bytes / Kilobytes(1)),
+               sites[i].count, sites[i].file, sites[i].line);
+    }
+#else
+    printf("Allocation sites are only tracked with GAME_MEMORY_DEBUG\n");
+#endif
 }
\ No newline at end of file
@@ -6,21 +6,162 @@
 #define Gigabytes(Value) (Megabytes(Value)*1024LL)
 #define Terabytes(Value) (Gigabytes(Value)*1024LL)
 
+//address space reserved up front, pages are only committed as push_size advances
+#define GAME_MEMORY_RESERVE_SIZE    Gigabytes(4)
+#define GAME_MEMORY_COMMIT_STEP     Megabytes(64)
+//size of each of the two per-frame transient arenas
+#define FRAME_MEMORY_SIZE           Megabytes(32)
+//sub arenas are carved on page boundaries so each one can commit its own pages
+#define ARENA_PAGE_SIZE             Kilobytes(4)
+#define MAX_NUM_SUB_ARENAS          16
+//address space job threads refill their arenas from, in blocks
+#define THREAD_MEMORY_BUDGET        Megabytes(512)
+#define THREAD_ARENA_BLOCK_SIZE     Megabytes(4)
+#define THREAD_TRANSIENT_SIZE       Megabytes(8)
+#define MAX_NUM_THREAD_ARENAS       16
+//address space freeable arenas take their blocks from, released blocks are reused before it grows
+#define BLOCK_MEMORY_BUDGET         Gigabytes(1)
+#define FREEABLE_ARENA_BLOCK_SIZE   Kilobytes(256)
+
+/*
+    GAME_MEMORY_DEBUG: every allocation is followed by a canary and records its call site and size,
+    rewound memory is poisoned. GAME_MEMORY_GUARD_PAGES: allocations are pushed up against a
+    no-access page instead of a canary, so an overrun faults right where it happens.
+*/
+#if defined(GAME_MEMORY_GUARD_PAGES) && !defined(GAME_MEMORY_DEBUG)
+#define GAME_MEMORY_DEBUG
+#endif
+
+#ifdef GAME_MEMORY_DEBUG
+#define ARENA_CANARY_SIZE       16
+#define ARENA_CANARY_BYTE       0xFD
+#define ARENA_POISON_BYTE       0xDD
+#define ARENA_MAX_DEBUG_RECORDS (1 << 20)
+//__builtin_FILE/__builtin_LINE as default arguments are evaluated at the call site
+#define ARENA_SITE_PARAMS , const char* file = __builtin_FILE(), uint32_t line = __builtin_LINE()
+#define ARENA_SITE_DECL   , const char* file, uint32_t line
+#define ARENA_SITE_ARGS   , file, line
+#else
+#define ARENA_SITE_PARAMS
+#define ARENA_SITE_DECL
+#define ARENA_SITE_ARGS
+#endif
+
+//define GAME_MEMORY_HUGE_PAGES to ask the kernel for transparent huge pages on the arena
+
+//16 covers SSE loads, 32 AVX, 64 keeps hot buffers on their own cache lines
+#define DEFAULT_ALIGNMENT 16
+#define SIMD_ALIGNMENT    32
+#define CACHE_LINE_SIZE   64
 
 #include <stdint.h>
 #include <stdlib.h>
 #include <cstring>
+#include <cassert>
+
+#define is_aligned(ptr, alignment) ((((uintptr_t)(ptr)) & ((uintptr_t)(alignment) - 1)) == 0)
+
+#ifndef NDEBUG
+#define assert_aligned(ptr, alignment) assert(is_aligned(ptr, alignment))
+#else
+#define assert_aligned(ptr, alignment)
+#endif
 
 struct memory_arena
 {
-    uint8_t* base;
-    uint64_t used;
-    uint64_t capacity;
-    bool initialized;
+    const char* name;
+    uint8_t*    base;
+    uint64_t    used;
+    uint64_t    committed;
+    uint64_t    capacity;   //budget for sub arenas
+    uint64_t    high_water;
+    uint64_t    block_size; //non zero for thread and freeable arenas, they grab a new block when full
+    uint8_t*    last_block; //freeable arenas only, every block links to the one before it
+    uint32_t    num_allocations;
+    uint32_t    temp_count;
+#ifdef GAME_MEMORY_DEBUG
+    uint32_t    debug_record_head; //newest allocation record of this arena, 0 if none
+#endif
+    bool        initialized;
+    bool        freeable;
+};
+
+//marks a point in an arena that everything pushed afterwards can be rolled back to
+struct temporary_memory
+{
+    memory_arena* arena;
+    uint8_t*      base; //block arenas may have moved on to a new block since
+    uint64_t      used;
 };
 
 void   fill_game_memory(void);
 bool   game_memory_init(void);
-void*  push_size(uint64_t size);
+void*  push_size(uint64_t size, uint64_t alignment = DEFAULT_ALIGNMENT ARENA_SITE_PARAMS);
+void*  push_size(memory_arena* arena, uint64_t size, uint64_t alignment = DEFAULT_ALIGNMENT ARENA_SITE_PARAMS);
 void   free_size(uint64_t size);
+void   print_game_memory_stats(void);
+void   check_arena_canaries(memory_arena* arena);
+void   print_arena_allocation_sites(uint32_t max_sites);
+
+memory_arena*    get_game_memory_arena(void);
+memory_arena*    create_sub_arena(const char* name, uint64_t budget);
+void             print_memory_arena_report(void);
+temporary_memory begin_temporary_memory(memory_arena* arena);
+void             end_temporary_memory(temporary_memory temp);
+//closes the scope but keeps everything pushed inside it
+void             keep_temporary_memory(temporary_memory temp);
+
+void             begin_frame_memory(void);
+memory_arena*    get_frame_arena(void);
+memory_arena*    get_previous_frame_arena(void);
+
+//thread arenas can only be used from the thread that attached them
+bool             thread_memory_init(uint32_t num_threads);
+void             attach_thread_memory(uint32_t thread_index);
+memory_arena*    get_thread_arena(void);
+memory_arena*    get_thread_transient_arena(void);
+//transient arena of the calling thread, the frame arena if it has none
+memory_arena*    get_scratch_arena(void);
+
+/*
+    Freeable arenas are for data that comes and goes, like assets that get evicted. They grow in
+    blocks like thread arenas do, and release hands every block back for other freeable arenas to
+    reuse. An arena is pushed to by one thread at a time, blocks are taken and returned under a lock.
+*/
+bool             block_memory_init(void);
+void             init_freeable_arena(memory_arena* arena, const char* name);
+void             release_freeable_arena(memory_arena* arena);
+//bytes the arena holds on to, block headers included
+uint64_t         get_freeable_arena_size(memory_arena* arena);
+
+//types with a stricter alignof than the default keep their own alignment
+template<typename T>
+constexpr uint64_t default_alignment_of(void)
+{
+    return alignof(T) > DEFAULT_ALIGNMENT ? alignof(T) : DEFAULT_ALIGNMENT;
+}
+
+template<typename T>
+inline T* push_array(uint64_t count, uint64_t alignment = default_alignment_of<T>() ARENA_SITE_PARAMS)
+{
+    return (T*)push_size(count * sizeof(T), alignment ARENA_SITE_ARGS);
+}
+
+template<typename T>
+inline T* push_struct(uint64_t alignment = default_alignment_of<T>() ARENA_SITE_PARAMS)
+{
+    return (T*)push_size(sizeof(T), alignment ARENA_SITE_ARGS);
+}
+
+template<typename T>
+inline T* push_array(memory_arena* arena, uint64_t count, uint64_t alignment = default_alignment_of<T>() ARENA_SITE_PARAMS)
+{
+    return (T*)push_size(arena, count * sizeof(T), alignment ARENA_SITE_ARGS);
+}
+
+template<typename T>
+inline T* push_struct(memory_arena* arena, uint64_t alignment = default_alignment_of<T>() ARENA_SITE_PARAMS)
+{
+    return (T*)push_size(arena, sizeof(T), alignment ARENA_SITE_ARGS);
+}
 #endif
\ No newline at end of file
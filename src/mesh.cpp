@@ -2,16 +2,28 @@
 
 #define  STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
-#include <unordered_map>
 #include <queue>
+#include <deque>
 
 #include <SDL.h>
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/MemoryIOWrapper.h>
 
 #include "entity.h"
 #include "character.h"
+#include "arena_allocator.h"
+#include "baked_asset.h"
+#include "pack.h"
+#include "mip_texture.h"
 
-static char m_current_directory[256];
+static memory_arena* m_mesh_arena;
+static memory_arena* m_animation_arena;
 static uint32_t m_starting_time;
+//interned once, draw_mesh tells the texture types apart by id
+static string_id m_texture_diffuse;
+static string_id m_texture_specular;
+static string_id m_texture_normal;
+static string_id m_texture_height;
 static volatile bool m_pause;
 
 void set_pause_anim(bool pause)
@@ -40,7 +52,7 @@ static void print_anim_data(character* p_character, skeletal_animation* p_anim)
             
         printf("Channel[%d]\n", i);
         printf("-------------------------------------------\n");
-        printf("Node name: %s, bone id: %d\n", p_node->node_name, p_node->m_bone_id);
+        printf("Node name: %s, bone id: %d\n", get_string(p_node->node_name), p_node->m_bone_id);
         printf("Num scale keys: %d\n", p_node->m_num_scale_keys);
         printf("Num rotation keys: %d\n", p_node->m_num_rotation_keys);
         printf("Num position keys: %d\n\n", p_node->m_num_position_keys);
@@ -191,6 +203,9 @@ void get_bone_transforms(character* p_character, float dt, uint32_t anim_index_1
     //glm::mat4 inverse_root_transform = p_character->m_meshes[0].m_global_inv_transform;
     //glm::mat4 root_transform = glm::inverse(inverse_root_transform);
 
+    assert_aligned(p_character->m_final_transformations, CACHE_LINE_SIZE);
+    assert_aligned(p_character->m_local_transformations, CACHE_LINE_SIZE);
+
     memset(p_character->m_final_transformations, 0, sizeof(glm::mat4) * MAX_NUM_BONES);
     memset(p_character->m_local_transformations, 0, sizeof(glm::mat4) * MAX_NUM_BONES);
 
@@ -245,8 +260,21 @@ void get_bone_transforms(character* p_character, float dt, uint32_t anim_index_1
     }
 }
 
+static bool evict_model(asset_entry* entry);
+static bool evict_texture(asset_entry* entry);
+static bool evict_animation(asset_entry* entry);
+
 void mesh_component_init(void)
 {   
+    m_mesh_arena      = create_sub_arena("meshes", MESH_MEMORY_BUDGET);
+    m_animation_arena = create_sub_arena("animations", ANIMATION_MEMORY_BUDGET);
+    m_texture_diffuse  = intern_string("texture_diffuse");
+    m_texture_specular = intern_string("texture_specular");
+    m_texture_normal   = intern_string("texture_normal");
+    m_texture_height   = intern_string("texture_height");
+    set_asset_evict_function(ASSET_TYPE_MESH, &evict_model);
+    set_asset_evict_function(ASSET_TYPE_TEXTURE, &evict_texture);
+    set_asset_evict_function(ASSET_TYPE_ANIMATION, &evict_animation);
     stbi_set_flip_vertically_on_load(false);
     m_starting_time = SDL_GetTicks();
     m_pause = false;
@@ -254,9 +282,9 @@ void mesh_component_init(void)
 
 /*
     fill the buffer with all the characters but not including the last "character
-    out buffer should be large enough, otherwise UB.
+    the result is truncated to fit out_size bytes including the terminator.
 */
-void get_directory_name(const char* in_buffer, char* out_buffer, uint8_t character)
+void get_directory_name(const char* in_buffer, char* out_buffer, uint32_t out_size, uint8_t character)
 {
     uint32_t found_index = 0;
 
@@ -278,46 +306,142 @@ void get_directory_name(const char* in_buffer, char* out_buffer, uint8_t charact
         return;
     }
 
+    if (last_found >= out_size)
+    {
+        last_found = out_size - 1;
+    }
     memcpy(out_buffer, in_buffer, last_found);
-    out_buffer[last_found + 1] = '\0';
+    out_buffer[last_found] = '\0';
 }
 
 
-//need to find directory first and then pass to this function
-uint32_t load_texture_from_file(const char* path, bool gamma)
+static GLenum get_texture_format(int32_t num_components)
+{
+    GLenum format = GL_RGBA;
+    switch(num_components)
+    {
+        case(1):
+            format = GL_RED;
+            break;
+        case(2):
+            format = GL_RG;
+            break;
+        case(3):
+            format = GL_RGB;
+            break;
+        case(4):
+            format = GL_RGBA;
+            break;
+        default:
+            break;
+    }
+    return format;
+}
+
+static void set_texture_parameters(void)
+{
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+//these return the bytes the texture takes on the GPU, mips included
+static uint64_t upload_texture(uint32_t texture_id, const uint8_t* data, int32_t width, int32_t height, int32_t num_components)
+{
+    GLenum format = get_texture_format(num_components);
+
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    set_texture_parameters();
+    //the mips add up to a third of level 0
+    return (uint64_t)width * height * num_components * 4 / 3;
+}
+
+//every level was made by the baker, nothing is generated here
+static uint64_t upload_mip_texture(uint32_t texture_id, const mip_texture_header* header)
+{
+    GLenum format = get_texture_format(header->num_components);
+
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    //levels are tightly packed, rows of the small ones aren't 4 byte multiples
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t level = 0; level < header->num_levels; ++level)
+    {
+        glTexImage2D(GL_TEXTURE_2D, level, format,
+                     get_mip_level_size(header->width, level), get_mip_level_size(header->height, level), 0,
+                     format, GL_UNSIGNED_BYTE, (const uint8_t*)header + header->level_offsets[level]);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header->num_levels - 1);
+    set_texture_parameters();
+    return header->file_size - header->level_offsets[0];
+}
+
+//the whole file in one malloc block, the same way stbi_load hands out texels. NULL unless it's usable
+static uint8_t* read_mip_texture_file(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t* result = size > 0 ? (uint8_t*)malloc((size_t)size) : NULL;
+    if (result && (fread(result, 1, (size_t)size, file) != (size_t)size ||
+                   !validate_mip_texture(result, (uint64_t)size, path)))
+    {
+        free(result);
+        result = NULL;
+    }
+    fclose(file);
+    return result;
+}
+
+/*
+    Takes the texture baked with its mips from the pack, then from next to the image (see
+    tools/asset_baker), and only decodes the image itself when neither is there.
+*/
+static uint32_t load_texture(const char* path, uint64_t* out_gpu_size)
 {
     uint32_t texture_id;
     glGenTextures(1, &texture_id);
-    int32_t width, height, num_components;
-    uint8_t* data = stbi_load(path, &width, &height, &num_components, 0);
+    *out_gpu_size = 0;
 
-    if(data)
+    //GL reads the levels straight from the mapping, or from the decompressed copy
+    uint64_t packed_size = 0;
+    const void* packed = pack_load(path, PACK_ENTRY_TEXTURE, NULL, &packed_size);
+    const mip_texture_header* header = packed ? validate_mip_texture(packed, packed_size, path) : NULL;
+    if (header)
     {
-        GLenum format;
-        switch(num_components)
-        {
-            case(1):
-                format = GL_RED;
-                break;
-            case(3):
-                format = GL_RGB;
-                break;
-            case(4):
-                format = GL_RGBA;
-                break;
-            default:
-                break;
-        }
+        *out_gpu_size = upload_mip_texture(texture_id, header);
+    }
+    pack_free(packed);
+    if (header)
+    {
+        return texture_id;
+    }
 
-        glBindTexture(GL_TEXTURE_2D, texture_id);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+    char baked_path[MAX_ASSET_PATH_LENGTH];
+    get_baked_path(path, MIP_TEXTURE_EXTENSION, baked_path, sizeof(baked_path));
+    uint8_t* baked = read_mip_texture_file(baked_path);
+    if (baked)
+    {
+        *out_gpu_size = upload_mip_texture(texture_id, (const mip_texture_header*)baked);
+        free(baked);
+        return texture_id;
+    }
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    int32_t width, height, num_components;
+    uint8_t* data = stbi_load(path, &width, &height, &num_components, 0);
 
+    if(data)
+    {
+        *out_gpu_size = upload_texture(texture_id, data, width, height, num_components);
         stbi_image_free(data);
     }
     else
@@ -327,7 +451,14 @@ uint32_t load_texture_from_file(const char* path, bool gamma)
     return texture_id;
 }
 
-void load_material_textures(mesh* p_mesh, aiMaterial* mat, aiTextureType type, const char* type_name)
+uint32_t load_texture_from_file(const char* path, bool gamma)
+{
+    uint64_t gpu_size;
+    return load_texture(path, &gpu_size);
+}
+
+//only records type and full path, the image is loaded when the mesh is uploaded
+void load_material_textures(mesh* p_mesh, aiMaterial* mat, aiTextureType type, string_id type_name, model_import* import)
 {
     uint32_t texture_count = mat->GetTextureCount(type);
 
@@ -336,41 +467,208 @@ void load_material_textures(mesh* p_mesh, aiMaterial* mat, aiTextureType type, c
         aiString str;
         mat->GetTexture(type, i, &str);
 
-        asset_tag _tag;
-        _tag.size = sizeof(asset_tag);
-        _tag.type = ASSET_TYPE_TEXTURE;
-        _tag.data = p_mesh->m_textures + p_mesh->m_num_textures;
-
         //construct full path
         char path[MAX_ASSET_PATH_LENGTH];
-        char* slash = "/";
-        memset(path, 0, MAX_ASSET_PATH_LENGTH);
-        strcpy(path, m_current_directory);
-        strcat(path, slash);
-        strcat(path, str.C_Str());
+        snprintf(path, sizeof(path), "%s/%s", import->m_directory, str.C_Str());
+
+        texture text;
+        text.id      = 0;
+        text.m_asset = 0;
+        text.m_type  = type_name;
+        text.m_path  = intern_string(path);
+        p_mesh->m_textures[p_mesh->m_num_textures++] = text;
+    }
+}
+
+//read and decoded on a job thread, waiting for the main thread to upload it
+struct decoded_image
+{
+    asset_read_job m_read; //first, the job function gets the image back from it
+    char           m_file[MAX_ASSET_PATH_LENGTH];
+    string_id      m_path;
+    uint8_t*       m_data; //the baked file if m_baked, else texels. NULL if the image couldn't be loaded
+    int32_t        m_width;
+    int32_t        m_height;
+    int32_t        m_num_components;
+    bool           m_baked;
+};
+
+static decoded_image* find_decoded_image(decoded_image* images, uint32_t num_images, string_id path)
+{
+    for (uint32_t i = 0; i < num_images; ++i)
+    {
+        if (images[i].m_path == path)
+        {
+            return images + i;
+        }
+    }
+    return NULL;
+}
+
+//true if it is the baked texture next to the image. A changed source is read from_source, the baked one is older
+static bool get_image_file(const char* path, bool from_source, char* out_path, uint32_t out_size)
+{
+    if (!from_source)
+    {
+        get_baked_path(path, MIP_TEXTURE_EXTENSION, out_path, out_size);
+        if (asset_file_exists(out_path))
+        {
+            return true;
+        }
+    }
+    snprintf(out_path, out_size, "%s", path);
+    return false;
+}
+
+//runs once the file is read, stb decodes straight from the read buffer
+static void decode_image_job(asset_subjob* job)
+{
+    decoded_image* image = (decoded_image*)job;
+    asset_io_request* file = &image->m_read.m_file;
+
+    if (image->m_baked)
+    {
+        //handed on as it is, the upload frees it
+        image->m_data = file->m_data;
+        if (image->m_data && !validate_mip_texture(image->m_data, file->m_size, file->m_path))
+        {
+            free_asset_io_data(file);
+            image->m_data = NULL;
+        }
+    }
+    else
+    {
+        image->m_data = file->m_data ? stbi_load_from_memory(file->m_data, (int)file->m_size, &image->m_width,
+                                                             &image->m_height, &image->m_num_components, 0) : NULL;
+        free_asset_io_data(file);
+    }
+    if (!image->m_data)
+    {
+        printf("texture failed to load at path: %s\n", get_string(image->m_path));
+    }
+}
+
+static void free_decoded_image(decoded_image* image)
+{
+    if (image->m_baked)
+    {
+        free(image->m_data);
+    }
+    else
+    {
+        stbi_image_free(image->m_data);
+    }
+    image->m_data = NULL;
+}
+
+/*
+    Job thread side of a streamed model, every image is read and then decoded in a job of its own so
+    a model with many materials has all its reads in flight at once and is decoded on all the job
+    threads. Textures in the pack need no decoding and the ones
+    some other model has uploaded get shared, those are skipped.
+*/
+static decoded_image* decode_model_textures(asset_load* load, entity* p_entity, memory_arena* arena, uint32_t* out_count)
+{
+    uint32_t max_images = 0;
+    for (uint32_t i = 0; i < p_entity->m_num_meshes; ++i)
+    {
+        max_images += p_entity->m_meshes[i].m_num_textures;
+    }
+    *out_count = 0;
+    decoded_image* images = max_images ? push_array<decoded_image>(arena, max_images) : NULL;
+    if (!images)
+    {
+        return NULL;
+    }
+
+    uint32_t num_images = 0;
+    for (uint32_t i = 0; i < p_entity->m_num_meshes; ++i)
+    {
+        mesh* p_mesh = p_entity->m_meshes + i;
+        for (uint32_t j = 0; j < p_mesh->m_num_textures; ++j)
+        {
+            string_id path_id = p_mesh->m_textures[j].m_path;
+            const char* path = get_string(path_id);
+            if (find_decoded_image(images, num_images, path_id) ||
+                pack_contains(path, PACK_ENTRY_TEXTURE) ||
+                is_asset_loaded(asset_path_hash(path)))
+            {
+                continue;
+            }
 
-        asset_tag tag_in_storage = find_asset_in_storage(path, _tag);
+            decoded_image* image = images + num_images++;
+            memset(image, 0, sizeof(decoded_image));
+            image->m_path  = path_id;
+            image->m_baked = get_image_file(path, false, image->m_file, sizeof(image->m_file));
+            submit_asset_read(load, &image->m_read, image->m_file, NULL, &decode_image_job);
+        }
+    }
+    *out_count = num_images;
+    return images;
+}
+
+static void free_decoded_images(decoded_image* images, uint32_t num_images)
+{
+    for (uint32_t i = 0; i < num_images; ++i)
+    {
+        free_decoded_image(images + i);
+    }
+}
 
-        if(_tag.data != tag_in_storage.data)
+/*
+    Images that were decoded on a job thread are uploaded as they are, anything else is loaded here.
+    Every texture holds a reference to its GL texture, the first mesh that uses it uploads it.
+*/
+static void upload_mesh_textures(mesh* p_mesh, decoded_image* images, uint32_t num_images)
+{
+    for (uint32_t i = 0; i < p_mesh->m_num_textures; ++i)
+    {
+        texture* text = p_mesh->m_textures + i;
+        const char* path = get_string(text->m_path);
+        text->m_asset = acquire_asset(path, ASSET_TYPE_TEXTURE);
+        asset_entry* entry = get_asset_entry(text->m_asset);
+        if (entry && entry->gpu_name)
         {
             printf("No need to load again texture, found %s\n", path);
-            //just copy the texture info
-            memcpy(p_mesh->m_textures + (p_mesh->m_num_textures++), tag_in_storage.data, sizeof(texture));
+            text->id = entry->gpu_name;
             continue;
         }
 
-        texture text;
-        text.id   = load_texture_from_file(path, false);
-        text.m_type = (char*)push_size(MAX_ASSET_PATH_LENGTH);
-        text.m_path = (char*)push_size(MAX_ASSET_PATH_LENGTH);
-        memset(text.m_type, 0, MAX_ASSET_PATH_LENGTH);
-        memset(text.m_path, 0, MAX_ASSET_PATH_LENGTH);
-        strcpy(text.m_type, type_name);
-        strcpy(text.m_path, path);
-        p_mesh->m_textures[p_mesh->m_num_textures++] = text;
+        uint64_t gpu_size = 0;
+        decoded_image* image = find_decoded_image(images, num_images, text->m_path);
+        if (!image)
+        {
+            text->id = load_texture(path, &gpu_size);
+        }
+        else
+        {
+            glGenTextures(1, &text->id);
+            if (image->m_baked)
+            {
+                gpu_size = upload_mip_texture(text->id, (const mip_texture_header*)image->m_data);
+            }
+            else if (image->m_data)
+            {
+                gpu_size = upload_texture(text->id, image->m_data, image->m_width, image->m_height, image->m_num_components);
+            }
+            free_decoded_image(image);
+        }
+
+        //without an entry it isn't shared, the mesh deletes it itself
+        if (text->m_asset)
+        {
+            set_asset_data(text->m_asset, NULL, text->id);
+            set_asset_size(text->m_asset, 0, gpu_size);
+        }
     }
 }
 
+static bool evict_texture(asset_entry* entry)
+{
+    glDeleteTextures(1, &entry->gpu_name);
+    return true;
+}
+
 void setup_mesh(mesh* p_mesh)
 {
     glGenVertexArrays(1, &p_mesh->vao);
@@ -430,14 +728,13 @@ static inline glm::quat GetGLMQuat(const aiQuaternion& pOrientation)
     return glm::quat(pOrientation.w, pOrientation.x, pOrientation.y, pOrientation.z);
 }
 
-static uint8_t find_bone_by_name(character* p_character, const char* name)
+uint8_t find_bone(character* p_character, string_id name)
 {
     uint8_t result = 0xFF;
 
     for (uint8_t i = 0; i < p_character->m_num_joints; ++i)
     {
-        char* joint_name = p_character->m_skeleton[i].m_name;
-        if (strcmp(joint_name, name) == 0)
+        if (p_character->m_skeleton[i].m_name == name)
         {
             result = i;
             break;
@@ -446,17 +743,25 @@ static uint8_t find_bone_by_name(character* p_character, const char* name)
     return result;
 }
 
+//a name that was never interned can't be a joint's
+uint8_t find_bone_by_name(character* p_character, const char* name)
+{
+    string_id id = find_string(name);
+    return id != NO_STRING ? find_bone(p_character, id) : 0xFF;
+}
+
 static void load_bones(character* p_character, mesh* p_mesh, aiMesh* ai_mesh)
 {
     for (uint32_t i = 0; i < ai_mesh->mNumBones; ++i)
     {
         const char* bone_name = ai_mesh->mBones[i]->mName.data;
         int bone_index = find_bone_by_name(p_character, bone_name);
-        //get offset
-        joint* bone = p_character->m_skeleton + bone_index;
-        bone->m_offset = ConvertMatrixToGLMFormat(ai_mesh->mBones[i]->mOffsetMatrix);
         if (bone_index != 0xFF) //found the bone
         {
+            //get offset
+            joint* bone = p_character->m_skeleton + bone_index;
+            bone->m_offset = ConvertMatrixToGLMFormat(ai_mesh->mBones[i]->mOffsetMatrix);
+
             for (uint32_t j = 0; j < ai_mesh->mBones[i]->mNumWeights; ++j)
             {
                 uint32_t vertex_id = ai_mesh->mBones[i]->mWeights[j].mVertexId;
@@ -534,12 +839,16 @@ uint32_t count_nodes(aiNode* p_node)
     return count;
 }
 
-void convert_skeleton_to_array(aiNode* root_node, joint* p_skeleton)
+template<typename T>
+using scratch_queue = std::queue<T, std::deque<T, arena_allocator<T>>>;
+
+//breadth first, so every joint comes after its parent
+static void walk_skeleton(aiNode* root_node, joint* p_skeleton, memory_arena* scratch)
 {
     uint32_t index = 0;
 
-    std::queue<aiNode*>node_queue;
-    std::queue<uint32_t>parent_indices;
+    scratch_queue<aiNode*>node_queue{arena_allocator<aiNode*>(scratch)};
+    scratch_queue<uint32_t>parent_indices{arena_allocator<uint32_t>(scratch)};
 
     node_queue.push(root_node);
     parent_indices.push(0xFF);
@@ -557,9 +866,7 @@ void convert_skeleton_to_array(aiNode* root_node, joint* p_skeleton)
         //do top node
         joint cur_joint = {};
         cur_joint.m_parent = parent_indices.front();
-        cur_joint.m_name = (char*)push_size(MAX_BONE_NAME_LEN);
-        const char* node_name = node->mName.C_Str();
-        strcpy(cur_joint.m_name, node_name);
+        cur_joint.m_name = intern_string(node->mName.C_Str());
         cur_joint.m_transformation = ConvertMatrixToGLMFormat(node->mTransformation);
 
         p_skeleton[index++] = cur_joint;
@@ -570,18 +877,32 @@ void convert_skeleton_to_array(aiNode* root_node, joint* p_skeleton)
     }
 }
 
-static skeleton_load_result create_skeleton(const aiScene* scene)
+void convert_skeleton_to_array(aiNode* root_node, joint* p_skeleton)
+{
+    //the queues only live for the walk, all of their memory goes back in one go
+    memory_arena* scratch = get_scratch_arena();
+    temporary_memory temp = begin_temporary_memory(scratch);
+    walk_skeleton(root_node, p_skeleton, scratch);
+    end_temporary_memory(temp);
+}
+
+static skeleton_load_result create_skeleton(const aiScene* scene, memory_arena* arena)
 {
     skeleton_load_result result = {};
 
     aiNode* root_joint = get_root_joint(scene);
+    if (!root_joint)
+    {
+        printf("No skeleton found in the scene\n");
+        return result;
+    }
 
     uint32_t num_joints = count_nodes(root_joint);
     
     printf("Num children root joint: %d\n", num_joints);
 
     result.m_num_joints = num_joints;
-    result.m_skeleton = (joint*)push_size(num_joints * sizeof(joint));
+    result.m_skeleton = push_array<joint>(arena, num_joints, CACHE_LINE_SIZE);
 
     convert_skeleton_to_array(root_joint, result.m_skeleton);
 
@@ -593,11 +914,11 @@ void print_skeleton(joint* p_skeleton, uint32_t num_joints)
     for (uint32_t i = 0; i < num_joints; ++i)
     {
         joint cur_joint = p_skeleton[i];
-        printf("Index: %d, Parent Index: %d, Joint Name: %s\n", i, cur_joint.m_parent, cur_joint.m_name);
+        printf("Index: %d, Parent Index: %d, Joint Name: %s\n", i, cur_joint.m_parent, get_string(cur_joint.m_name));
     }
 }
 
-static void load_animation(const aiScene* scene, character* p_character)
+static void load_animation(const aiScene* scene, character* p_character, memory_arena* arena)
 {
     const aiAnimation* p_ai_anim = scene->mAnimations[0];
     skeletal_animation* p_anim = p_character->m_animations + p_character->m_num_animations;
@@ -610,7 +931,7 @@ static void load_animation(const aiScene* scene, character* p_character)
     p_anim->m_last_time_index = 0;
     p_anim->m_last_time = 0.0f;
     //need to allocate enough memory for all bones. will check for != 0xFF while animating
-    p_anim->m_channels = (anim_node*)push_size(p_character->m_num_joints * sizeof(anim_node));
+    p_anim->m_channels = push_array<anim_node>(arena, p_character->m_num_joints, CACHE_LINE_SIZE);
 
     //nullify all bone_ids first
     for (uint32_t j = 0; j < p_character->m_num_joints; ++j)
@@ -622,38 +943,47 @@ static void load_animation(const aiScene* scene, character* p_character)
     {
         aiNodeAnim* p_ai_anim_node = p_ai_anim->mChannels[j];
         const char* bone_name = p_ai_anim_node->mNodeName.C_Str();
-        uint32_t bone_index = find_bone_by_name(p_character, bone_name);
+        string_id bone_id = find_string(bone_name);
+        uint32_t bone_index = bone_id != NO_STRING ? find_bone(p_character, bone_id) : 0xFF;
+        if (bone_index == 0xFF)
+        {
+            printf("Animation channel %s has no joint in the skeleton\n", bone_name);
+            continue;
+        }
 
         anim_node* p_anim_node = p_anim->m_channels + bone_index;
 
         p_anim_node->m_bone_id = bone_index;
 
-        p_anim_node->node_name = (char*)push_size(MAX_BONE_NAME_LEN);
-        strcpy(p_anim_node->node_name, bone_name);
+        p_anim_node->node_name = bone_id;
 
         p_anim_node->m_num_position_keys = p_ai_anim_node->mNumPositionKeys;
         p_anim_node->m_num_rotation_keys = p_ai_anim_node->mNumRotationKeys;
         p_anim_node->m_num_scale_keys = p_ai_anim_node->mNumScalingKeys;
 
-        p_anim_node->m_position_keys = (pos_key*)push_size(p_anim_node->m_num_position_keys * sizeof(pos_key));
-        p_anim_node->m_rotation_keys = (quat_key*)push_size(p_anim_node->m_num_rotation_keys * sizeof(quat_key));
-        p_anim_node->m_scale_keys = (scale_key*)push_size(p_anim_node->m_num_scale_keys * sizeof(scale_key));
+        p_anim_node->m_position_keys = push_array<pos_key>(arena, p_anim_node->m_num_position_keys);
+        p_anim_node->m_rotation_keys = push_array<quat_key>(arena, p_anim_node->m_num_rotation_keys);
+        p_anim_node->m_scale_keys = push_array<scale_key>(arena, p_anim_node->m_num_scale_keys);
 
+        //the three key counts don't have to match
         for (uint32_t k = 0; k < p_anim_node->m_num_position_keys; ++k)
         {
-            //get position keys
             pos_key* position = p_anim_node->m_position_keys + k;
             aiVectorKey* ai_position = p_ai_anim_node->mPositionKeys + k;
 
             position->m_time = ai_position->mTime;
             position->m_value = glm::vec3(ai_position->mValue.x, ai_position->mValue.y, ai_position->mValue.z);
-            //get scale keys
+        }
+        for (uint32_t k = 0; k < p_anim_node->m_num_scale_keys; ++k)
+        {
             scale_key* scale = p_anim_node->m_scale_keys + k;
             aiVectorKey* ai_scale = p_ai_anim_node->mScalingKeys + k;
 
             scale->m_time = ai_scale->mTime;
             scale->m_value = glm::vec3(ai_scale->mValue.x, ai_scale->mValue.y, ai_scale->mValue.z);
-            //get rotation keys
+        }
+        for (uint32_t k = 0; k < p_anim_node->m_num_rotation_keys; ++k)
+        {
             quat_key* rotation = p_anim_node->m_rotation_keys + k;
             aiQuatKey* ai_rotation = p_ai_anim_node->mRotationKeys + k;
 
@@ -664,20 +994,166 @@ static void load_animation(const aiScene* scene, character* p_character)
     p_character->m_num_animations++;
 }
 
-void load_animation_from_file(character* p_character, const char* path)
+//the source that was read ahead comes from memory, whatever else Assimp opens (materials) from the disk
+class source_io_system : public Assimp::DefaultIOSystem
+{
+public:
+    source_io_system(const char* path, const asset_io_request* source) : m_path(path), m_source(source) {}
+
+    bool Exists(const char* path) const override
+    {
+        return strcmp(path, m_path) == 0 || Assimp::DefaultIOSystem::Exists(path);
+    }
+
+    Assimp::IOStream* Open(const char* path, const char* mode = "rb") override
+    {
+        if (strcmp(path, m_path) == 0 && !strchr(mode, 'w'))
+        {
+            return new Assimp::MemoryIOStream(m_source->m_data, (size_t)m_source->m_size, false);
+        }
+        return Assimp::DefaultIOSystem::Open(path, mode);
+    }
+
+private:
+    const char*             m_path;
+    const asset_io_request* m_source;
+};
+
+static const aiScene* read_scene(Assimp::Importer* importer, const char* path, const asset_io_request* source)
+{
+    if (source && source->m_data)
+    {
+        //the importer owns it from here on
+        importer->SetIOHandler(new source_io_system(path, source));
+    }
+    return importer->ReadFile(path, MODEL_IMPORT_FLAGS);
+}
+
+bool import_animation(character* p_character, const char* path, memory_arena* arena, const asset_io_request* source)
 {
     Assimp::Importer importer;
 
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate |
-        aiProcess_GenSmoothNormals | aiProcess_FlipUVs |
-        aiProcess_CalcTangentSpace);
+    const aiScene* scene = read_scene(&importer, path, source);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
         printf("ERROR::ASSIMP:: %s\n", importer.GetErrorString());
-        return;
+        return false;
+    }
+    if (scene->mNumAnimations == 0)
+    {
+        printf("No animation in %s\n", path);
+        return false;
+    }
+    load_animation(scene, p_character, arena);
+    return true;
+}
+
+bool import_animation(character* p_character, const char* path)
+{
+    return import_animation(p_character, path, m_animation_arena);
+}
+
+/*
+    Everything besides the source file that changes what an import produces. Texture paths are
+    stored resolved against the source's directory, so the same file in another folder is another
+    import.
+*/
+static uint64_t get_model_import_seed(entity* p_entity, const char* path)
+{
+    uint32_t key[4] = { MODEL_IMPORT_FLAGS, BAKED_ASSET_VERSION, baked_asset_layout(), (uint32_t)p_entity->m_type };
+    const char* last_slash = strrchr(path, '/');
+    uint64_t directory_length = last_slash ? (uint64_t)(last_slash - path) : 0;
+    return hash64(path, directory_length, hash64(key, sizeof(key)));
+}
+
+//only channels of joints in the skeleton are kept, so the skeleton is part of it too
+static uint64_t get_animation_import_seed(character* p_character)
+{
+    uint32_t key[4] = { MODEL_IMPORT_FLAGS, BAKED_ASSET_VERSION, baked_asset_layout(), p_character->m_num_joints };
+    uint64_t seed = hash64(key, sizeof(key));
+    for (uint32_t i = 0; i < p_character->m_num_joints; ++i)
+    {
+        uint64_t name_hash = get_string_hash(p_character->m_skeleton[i].m_name);
+        seed = hash64(&name_hash, sizeof(name_hash), seed);
+    }
+    return seed;
+}
+
+/*
+    What a load reads ahead, without a job thread waiting on it: the baked file next to the source if
+    it may use it, else the source. False if it is in the pack and there is nothing to read.
+*/
+static bool get_read_ahead_file(const char* path, bool from_source, char* out_path, uint32_t out_size, bool* out_baked)
+{
+    *out_baked = false;
+    if (!from_source)
+    {
+        if (pack_contains(path, PACK_ENTRY_BAKED))
+        {
+            return false;
+        }
+        get_baked_asset_path(path, out_path, out_size);
+        if (asset_file_exists(out_path))
+        {
+            *out_baked = true;
+            return true;
+        }
+    }
+    snprintf(out_path, out_size, "%s", path);
+    return true;
+}
+
+//the same order as read_model
+static bool read_animation(character* p_character, const char* path, memory_arena* arena, bool from_source,
+                           const asset_io_request* file)
+{
+    const asset_io_request* source = file && strcmp(file->m_path, path) == 0 ? file : NULL;
+    if (!from_source)
+    {
+        uint64_t packed_size = 0;
+        const void* packed = pack_load(path, PACK_ENTRY_BAKED, arena, &packed_size);
+        if (packed && load_baked_animation_from_memory(p_character, packed, packed_size, path, arena))
+        {
+            return true;
+        }
+
+        if (file && !source)
+        {
+            if (file->m_data && load_baked_animation_from_memory(p_character, file->m_data, file->m_size, file->m_path, arena))
+            {
+                return true;
+            }
+        }
+        else
+        {
+            char baked_path[MAX_ASSET_PATH_LENGTH];
+            get_baked_asset_path(path, baked_path, sizeof(baked_path));
+            if (load_baked_animation(p_character, baked_path, arena))
+            {
+                return true;
+            }
+        }
+    }
+
+    char cache_path[MAX_ASSET_PATH_LENGTH];
+    bool cacheable = get_import_cache_path(path, get_animation_import_seed(p_character), cache_path, sizeof(cache_path),
+                                           source ? source->m_data : NULL, source ? source->m_size : 0);
+    if (cacheable && load_baked_animation(p_character, cache_path, arena))
+    {
+        return true;
+    }
+
+    uint32_t anim_index = p_character->m_num_animations;
+    if (!import_animation(p_character, path, arena, source))
+    {
+        return false;
     }
-    load_animation(scene, p_character);
+    if (cacheable)
+    {
+        write_cached_animation(p_character, anim_index, cache_path);
+    }
+    return true;
 }
 
 static void load_vertices(aiMesh* ai_mesh, mesh* p_mesh, uint32_t mesh_vertex_count)
@@ -732,13 +1208,13 @@ static void load_vertices(aiMesh* ai_mesh, mesh* p_mesh, uint32_t mesh_vertex_co
     }
 }
 
-static void load_indices(aiMesh* ai_mesh, mesh* p_mesh)
+static void load_indices(aiMesh* ai_mesh, mesh* p_mesh, memory_arena* arena)
 {
     //assume every face is a triangle
     uint32_t num_faces = ai_mesh->mNumFaces;
     uint32_t num_indices = 0;
     uint32_t index_count = num_faces * 3;
-    p_mesh->m_indices = (uint32_t*)push_size(index_count * sizeof(uint32_t));
+    p_mesh->m_indices = push_array<uint32_t>(arena, index_count, SIMD_ALIGNMENT);
     p_mesh->m_num_indices = index_count;
 
     for (uint32_t j = 0; j < num_faces; ++j)
@@ -751,23 +1227,21 @@ static void load_indices(aiMesh* ai_mesh, mesh* p_mesh)
     }
 }
 
-static void load_materials(const aiScene* scene, aiMesh* ai_mesh, mesh* p_mesh)
+static void load_materials(const aiScene* scene, aiMesh* ai_mesh, mesh* p_mesh, model_import* import)
 {
     aiMaterial* material = scene->mMaterials[ai_mesh->mMaterialIndex];
     uint32_t num_textures = get_mesh_texture_count(material);
 
-    p_mesh->m_textures = (texture*)push_size(num_textures * sizeof(texture));
+    p_mesh->m_textures = push_array<texture>(import->m_mesh_arena, num_textures);
     p_mesh->m_num_textures = 0;
 
-    load_material_textures(p_mesh, material, aiTextureType_DIFFUSE, "texture_diffuse");
-    load_material_textures(p_mesh, material, aiTextureType_SPECULAR, "texture_specular");
-    load_material_textures(p_mesh, material, aiTextureType_HEIGHT, "texture_normal");
-    load_material_textures(p_mesh, material, aiTextureType_AMBIENT, "texture_height");
-
-    setup_mesh(p_mesh);
+    load_material_textures(p_mesh, material, aiTextureType_DIFFUSE, m_texture_diffuse, import);
+    load_material_textures(p_mesh, material, aiTextureType_SPECULAR, m_texture_specular, import);
+    load_material_textures(p_mesh, material, aiTextureType_HEIGHT, m_texture_normal, import);
+    load_material_textures(p_mesh, material, aiTextureType_AMBIENT, m_texture_height, import);
 }
 
-static void load_meshes(const aiScene* scene, entity* p_entity, uint32_t mesh_count, uint32_t animation_count)
+static void load_meshes(const aiScene* scene, entity* p_entity, uint32_t mesh_count, model_import* import)
 {
     //now need to extract data from assimp data structure
     for (uint32_t i = 0; i < mesh_count; ++i)
@@ -779,69 +1253,1160 @@ static void load_meshes(const aiScene* scene, entity* p_entity, uint32_t mesh_co
 
         //initiate mesh and increment numbers
         uint32_t mesh_vertex_count = ai_mesh->mNumVertices;
-        p_mesh->m_vertices = (vertex*)push_size(mesh_vertex_count * sizeof(vertex));
+        p_mesh->m_vertices = push_array<vertex>(import->m_mesh_arena, mesh_vertex_count, SIMD_ALIGNMENT);
         p_mesh->m_num_vertices = mesh_vertex_count;
 
         load_vertices(ai_mesh, p_mesh, mesh_vertex_count);
         /* extract bone information */
         if (p_entity->m_type == ET_CHARACTER)
         {
-            character* p_character = (character*)p_entity;
-            load_bones(p_character, p_mesh, ai_mesh);
-            //allocate animations
-            p_character->m_num_animations = 0;
-            p_character->m_animations = (skeletal_animation*)push_size(animation_count * sizeof(skeletal_animation));
-
-            load_animation(scene, p_character);
+            load_bones((character*)p_entity, p_mesh, ai_mesh);
         }
-        load_indices(ai_mesh, p_mesh);
-        load_materials(scene, ai_mesh, p_mesh);
+        load_indices(ai_mesh, p_mesh, import->m_mesh_arena);
+        load_materials(scene, ai_mesh, p_mesh, import);
     }
 }
 
-static void load_skeleton(const aiScene* scene, character* p_character)
+static void load_skeleton(const aiScene* scene, character* p_character, memory_arena* arena)
 {
     //check skeleton
-    skeleton_load_result anim_skeleton = create_skeleton(scene);
+    skeleton_load_result anim_skeleton = create_skeleton(scene, arena);
     print_skeleton(anim_skeleton.m_skeleton, anim_skeleton.m_num_joints);
 
     p_character->m_skeleton = anim_skeleton.m_skeleton;
     p_character->m_num_joints = anim_skeleton.m_num_joints;
 }
 
-void load_model_from_file(entity* p_entity, const char* path, uint32_t num_animations)
+/*
+    Reads the source file through Assimp into arena memory, from the source if it was read already.
+    Doesn't touch GL, so the asset baker can run it without a context, upload_model does the GL side.
+*/
+bool import_model(entity* p_entity, const char* path, uint32_t num_animations, memory_arena* mesh_arena,
+                  memory_arena* animation_arena, const asset_io_request* source)
 {
     Assimp::Importer importer;
 
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | 
-                                                   aiProcess_GenSmoothNormals | aiProcess_FlipUVs |
-                                                   aiProcess_CalcTangentSpace);
+    const aiScene* scene = read_scene(&importer, path, source);
 
     if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
         printf("ERROR::ASSIMP:: %s\n", importer.GetErrorString());
-        return;
+        return false;
     }
-    //clear directory buffer
-    memset(m_current_directory, 0, sizeof(m_current_directory));
-    //get the current working directory
-    get_directory_name(path, m_current_directory, '/');
+    model_import import = {};
+    import.m_mesh_arena      = mesh_arena;
+    import.m_animation_arena = animation_arena;
+    //texture paths are relative to the model's directory
+    get_directory_name(path, import.m_directory, sizeof(import.m_directory), '/');
 
     uint32_t mesh_count = scene->mNumMeshes;
     p_entity->m_num_meshes = mesh_count;
-    p_entity->m_meshes = (mesh*)push_size(p_entity->m_num_meshes * sizeof(mesh));
+    p_entity->m_meshes = push_array<mesh>(mesh_arena, p_entity->m_num_meshes);
     
     if (p_entity->m_type == ET_CHARACTER)
     {
-        load_skeleton(scene, (character*)p_entity);
+        load_skeleton(scene, (character*)p_entity, mesh_arena);
     }
 
-    load_meshes(scene, p_entity, mesh_count, num_animations);
+    load_meshes(scene, p_entity, mesh_count, &import);
+
+    if (p_entity->m_type == ET_CHARACTER)
+    {
+        character* p_character = (character*)p_entity;
+        //allocate animations
+        p_character->m_num_animations = 0;
+        p_character->m_animations = push_array<skeletal_animation>(animation_arena, num_animations);
+        if (scene->mNumAnimations > 0)
+        {
+            load_animation(scene, p_character, animation_arena);
+        }
+    }
+    return true;
 }
 
-void draw_mesh(mesh* p_mesh, shader s)
+bool import_model(entity* p_entity, const char* path, uint32_t num_animations)
 {
-    uint32_t diffuse_nr  = 1;
+    return import_model(p_entity, path, num_animations, m_mesh_arena, m_animation_arena);
+}
+
+void upload_model(entity* p_entity)
+{
+    for (uint32_t i = 0; i < p_entity->m_num_meshes; ++i)
+    {
+        mesh* p_mesh = p_entity->m_meshes + i;
+        upload_mesh_textures(p_mesh, NULL, 0);
+        setup_mesh(p_mesh);
+    }
+}
+
+/*
+    Looks in the pack first, then for a baked file next to the source (see tools/asset_baker), then
+    in the import cache, and only imports the source itself when none of them has it. A source that
+    changed while the game runs is read from_source, past the pack and the baked file, the cache is
+    keyed by the contents so it can't be out of date. The file from get_read_ahead_file is used from
+    memory, NULL if nothing was read ahead. Returns where the model came from, NULL if it couldn't be
+    read at all. Doesn't touch GL, so it also runs on job threads.
+*/
+static const char* read_model(entity* p_entity, const char* path, uint32_t num_animations,
+                              memory_arena* mesh_arena, memory_arena* animation_arena, bool from_source,
+                              const asset_io_request* file)
+{
+    const asset_io_request* source = file && strcmp(file->m_path, path) == 0 ? file : NULL;
+    if (!from_source)
+    {
+        uint64_t packed_size = 0;
+        //a compressed one is decompressed into the mesh arena, it is used in place like the mapping
+        const void* packed = pack_load(path, PACK_ENTRY_BAKED, mesh_arena, &packed_size);
+        if (packed && load_baked_model_from_memory(p_entity, packed, packed_size, path, num_animations, mesh_arena, animation_arena))
+        {
+            return "pack";
+        }
+
+        if (file && !source)
+        {
+            //read into the mesh arena, it is used in place
+            if (file->m_data && load_baked_model_from_memory(p_entity, file->m_data, file->m_size, file->m_path,
+                                                             num_animations, mesh_arena, animation_arena))
+            {
+                return "baked file";
+            }
+        }
+        else
+        {
+            char baked_path[MAX_ASSET_PATH_LENGTH];
+            get_baked_asset_path(path, baked_path, sizeof(baked_path));
+            if (load_baked_model(p_entity, baked_path, num_animations, mesh_arena, animation_arena))
+            {
+                return "baked file";
+            }
+        }
+    }
+
+    char cache_path[MAX_ASSET_PATH_LENGTH];
+    bool cacheable = get_import_cache_path(path, get_model_import_seed(p_entity, path), cache_path, sizeof(cache_path),
+                                           source ? source->m_data : NULL, source ? source->m_size : 0);
+    if (cacheable && load_baked_model(p_entity, cache_path, num_animations, mesh_arena, animation_arena))
+    {
+        return "import cache";
+    }
+
+    if (!import_model(p_entity, path, num_animations, mesh_arena, animation_arena, source))
+    {
+        return NULL;
+    }
+    if (cacheable)
+    {
+        write_cached_model(p_entity, cache_path);
+    }
+    return "source";
+}
+
+/*
+    A model as every entity that uses it shares it. The template holds the meshes, the skeleton and
+    the model's own animations, all of it in the model's arena, which goes back when it is evicted.
+*/
+struct model_data
+{
+    memory_arena m_arena;
+    character    m_model;
+    asset_id     m_id;
+    asset_handle m_load;           //0 if it was read on the main thread
+    uint32_t     m_num_animations; //asked for when it was first read, a reload asks for the same
+    bool         m_from_source;    //reread after its source changed
+    bool         m_reload;         //doesn't fail when it can't be read, the old data stays
+};
+
+//animation keys bound to one model's skeleton, shared by every character using that model
+struct animation_data
+{
+    memory_arena       m_arena;
+    character          m_model;    //borrows the model's skeleton while the channels are bound
+    skeletal_animation m_animations[MAX_ANIMATIONS_PER_CHARACTER];
+    asset_id           m_id;
+    asset_id           m_model_id; //bound to, only held while the keys are loaded
+    asset_handle       m_load;
+    bool               m_from_source;
+};
+
+//what a model's job hands over to its upload steps
+struct model_load
+{
+    asset_read_job m_read; //first, the parse job gets the load back from it
+    char           m_file[MAX_ASSET_PATH_LENGTH];
+    decoded_image* m_images;
+    uint32_t       m_num_images;
+};
+
+//the file of an animation's load
+struct animation_load
+{
+    asset_read_job m_read; //first
+    char           m_file[MAX_ASSET_PATH_LENGTH];
+};
+
+static inline bool is_load_finished(asset_handle handle)
+{
+    asset_state state = get_asset_state(handle);
+    return state == ASSET_STATE_NONE || state == ASSET_STATE_READY || state == ASSET_STATE_FAILED;
+}
+
+static void* get_asset_data(asset_id id)
+{
+    asset_entry* entry = get_asset_entry(id);
+    return entry ? entry->data : NULL;
+}
+
+//the struct lives in its own freeable arena, together with everything loaded into it
+template<typename T>
+static T* alloc_asset_data(asset_id id, const char* name)
+{
+    memory_arena arena;
+    init_freeable_arena(&arena, name);
+    T* result = push_struct<T>(&arena);
+    if (!result)
+    {
+        release_freeable_arena(&arena);
+        return NULL;
+    }
+    memset(result, 0, sizeof(T));
+    result->m_arena = arena;
+    result->m_id    = id;
+    return result;
+}
+
+template<typename T>
+static T* create_asset_data(asset_id id, const char* name)
+{
+    T* result = alloc_asset_data<T>(id, name);
+    if (result)
+    {
+        set_asset_data(id, result, 0);
+    }
+    return result;
+}
+
+static void free_asset_data(memory_arena* arena)
+{
+    //the arena is inside the memory it releases
+    memory_arena copy = *arena;
+    release_freeable_arena(&copy);
+}
+
+static uint64_t get_model_gpu_size(entity* p_model)
+{
+    uint64_t result = 0;
+    for (uint32_t i = 0; i < p_model->m_num_meshes; ++i)
+    {
+        mesh* p_mesh = p_model->m_meshes + i;
+        result += p_mesh->m_num_vertices * sizeof(vertex) + p_mesh->m_num_indices * sizeof(uint32_t);
+    }
+    return result;
+}
+
+//textures are only released, whatever else uses them keeps them
+static void free_model(model_data* model)
+{
+    entity* p_model = &model->m_model;
+    for (uint32_t i = 0; i < p_model->m_num_meshes; ++i)
+    {
+        mesh* p_mesh = p_model->m_meshes + i;
+        if (p_mesh->vao)
+        {
+            glDeleteVertexArrays(1, &p_mesh->vao);
+            glDeleteBuffers(1, &p_mesh->vbo);
+            glDeleteBuffers(1, &p_mesh->ebo);
+        }
+        for (uint32_t j = 0; j < p_mesh->m_num_textures; ++j)
+        {
+            texture* text = p_mesh->m_textures + j;
+            if (text->m_asset)
+            {
+                release_asset(text->m_asset);
+            }
+            else if (text->id)
+            {
+                glDeleteTextures(1, &text->id);
+            }
+        }
+    }
+    release_asset_load(model->m_load);
+    free_asset_data(&model->m_arena);
+}
+
+static bool evict_model(asset_entry* entry)
+{
+    model_data* model = (model_data*)entry->data;
+    if (!is_load_finished(model->m_load))
+    {
+        return false;
+    }
+    free_model(model);
+    return true;
+}
+
+static bool evict_animation(asset_entry* entry)
+{
+    animation_data* anim = (animation_data*)entry->data;
+    if (!is_load_finished(anim->m_load))
+    {
+        return false;
+    }
+    release_asset_load(anim->m_load);
+    free_asset_data(&anim->m_arena);
+    return true;
+}
+
+void release_entity_assets(entity* p_entity)
+{
+    release_asset(p_entity->m_model);
+    p_entity->m_model      = 0;
+    p_entity->m_meshes     = NULL;
+    p_entity->m_num_meshes = 0;
+
+    if (p_entity->m_type == ET_CHARACTER)
+    {
+        character* p_character = (character*)p_entity;
+        for (uint32_t i = 0; i < p_character->m_num_animation_assets; ++i)
+        {
+            release_asset(p_character->m_animation_assets[i]);
+        }
+        p_character->m_num_animation_assets = 0;
+        p_character->m_skeleton       = NULL;
+        p_character->m_num_joints     = 0;
+        p_character->m_num_animations = 0;
+    }
+}
+
+//the entity lets go of its old model and animations, a new model is read by whoever asked for it first
+static model_data* acquire_model(entity* p_entity, const char* path, bool* out_created)
+{
+    *out_created = false;
+    asset_id id = acquire_asset(path, ASSET_TYPE_MESH);
+    if (!id)
+    {
+        return NULL;
+    }
+
+    model_data* model = (model_data*)get_asset_data(id);
+    if (model && p_entity->m_type == ET_CHARACTER && model->m_model.m_type != ET_CHARACTER)
+    {
+        printf("%s was loaded without its skeleton, a character can not use it\n", path);
+        release_asset(id);
+        return NULL;
+    }
+    if (!model)
+    {
+        model = create_asset_data<model_data>(id, "model");
+        if (!model)
+        {
+            release_asset(id);
+            return NULL;
+        }
+        model->m_model.m_type = p_entity->m_type;
+        *out_created = true;
+    }
+
+    release_entity_assets(p_entity);
+    p_entity->m_model = id;
+    return model;
+}
+
+//every character plays the shared keys with a playback state of its own
+static void add_character_animation(character* p_character, skeletal_animation* p_anim)
+{
+    assert(p_character->m_animations);
+    if (p_character->m_num_animations == MAX_ANIMATIONS_PER_CHARACTER)
+    {
+        printf("Too many animations on character %u\n", p_character->m_id);
+        return;
+    }
+    skeletal_animation* result = p_character->m_animations + p_character->m_num_animations++;
+    *result = *p_anim;
+    result->m_last_time_index = 0;
+    result->m_last_time       = 0.0f;
+}
+
+static void attach_model(entity* p_entity, model_data* model)
+{
+    p_entity->m_meshes     = model->m_model.m_meshes;
+    p_entity->m_num_meshes = model->m_model.m_num_meshes;
+    if (p_entity->m_type != ET_CHARACTER)
+    {
+        return;
+    }
+
+    character* p_character = (character*)p_entity;
+    character* p_model     = &model->m_model;
+    p_character->m_skeleton       = p_model->m_skeleton;
+    p_character->m_num_joints     = p_model->m_num_joints;
+    p_character->m_num_animations = 0;
+    for (uint32_t i = 0; i < p_model->m_num_animations; ++i)
+    {
+        add_character_animation(p_character, p_model->m_animations + i);
+    }
+}
+
+static bool attach_model_step(asset_load* load)
+{
+    entity* p_entity = (entity*)load->m_target;
+    //unless the entity was destroyed or moved on to another model in the meantime
+    if (p_entity->m_model == load->m_param)
+    {
+        attach_model(p_entity, (model_data*)get_asset_data(load->m_param));
+    }
+    return true;
+}
+
+//the entity isn't drawn until the model is there and attached
+static void begin_model_attach(entity* p_entity, model_data* model, const char* path)
+{
+    //the new load holds on to the one it follows
+    asset_handle previous = p_entity->m_asset;
+    p_entity->m_asset = begin_asset_load(path, NULL, &attach_model_step, p_entity, model->m_id,
+                                         previous, model->m_load);
+    release_asset_load(previous);
+}
+
+void load_model_from_file(entity* p_entity, const char* path, uint32_t num_animations)
+{
+    uint64_t start = SDL_GetPerformanceCounter();
+    bool created = false;
+    model_data* model = acquire_model(p_entity, path, &created);
+    if (!model)
+    {
+        return;
+    }
+    if (!created)
+    {
+        if (!is_load_finished(model->m_load))
+        {
+            //somebody else is streaming it in
+            begin_model_attach(p_entity, model, path);
+        }
+        else if (get_asset_state(model->m_load) != ASSET_STATE_FAILED)
+        {
+            attach_model(p_entity, model);
+        }
+        return;
+    }
+
+    model->m_num_animations = num_animations;
+    const char* source = read_model(&model->m_model, path, num_animations, &model->m_arena, &model->m_arena, false, NULL);
+    if (!source)
+    {
+        //nothing half read stays behind, the next load tries again
+        set_asset_data(model->m_id, NULL, 0);
+        free_asset_data(&model->m_arena);
+        release_entity_assets(p_entity);
+        return;
+    }
+    upload_model(&model->m_model);
+    set_asset_size(model->m_id, get_freeable_arena_size(&model->m_arena), get_model_gpu_size(&model->m_model));
+    attach_model(p_entity, model);
+    uint64_t end = SDL_GetPerformanceCounter();
+
+    printf("Loaded %s from %s in %.3f ms\n", path, source,
+           (double)(end - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+static void parse_model(asset_load* load, model_load* result, asset_io_request* file)
+{
+    model_data* model = (model_data*)load->m_target;
+    memory_arena* arena = &model->m_arena;
+
+    bool ok = read_model(&model->m_model, load->m_path, load->m_param, arena, arena, model->m_from_source, file) != NULL;
+    if (file)
+    {
+        free_asset_io_data(file);
+    }
+    if (!ok)
+    {
+        if (!model->m_reload)
+        {
+            fail_asset_load(load);
+        }
+        return;
+    }
+    //the decodes finish as subjobs of this load, before any of it is uploaded
+    result->m_images = decode_model_textures(load, &model->m_model, arena, &result->m_num_images);
+    load->m_result = result;
+}
+
+static void parse_model_job(asset_subjob* job)
+{
+    model_load* result = (model_load*)job;
+    parse_model(job->m_load, result, &result->m_read.m_file);
+}
+
+/*
+    Only this load's jobs push to the model's arena until its upload steps are done, a baked file is
+    read straight into it. A reload that can't be read leaves m_result NULL instead of failing.
+*/
+static bool read_model_job(asset_load* load)
+{
+    model_data* model = (model_data*)load->m_target;
+    model_load* result = push_struct<model_load>(&model->m_arena);
+    if (!result)
+    {
+        return model->m_reload;
+    }
+    memset(result, 0, sizeof(model_load));
+
+    bool baked;
+    if (!get_read_ahead_file(load->m_path, model->m_from_source, result->m_file, sizeof(result->m_file), &baked))
+    {
+        parse_model(load, result, NULL);
+        return true;
+    }
+    submit_asset_read(load, &result->m_read, result->m_file, baked ? &model->m_arena : NULL, &parse_model_job);
+    return true;
+}
+
+//one mesh per step, so a model with many meshes is spread over several frames
+static bool upload_model_step(asset_load* load)
+{
+    model_data* model = (model_data*)load->m_target;
+    entity* p_model = &model->m_model;
+    model_load* result = (model_load*)load->m_result;
+
+    if (load->m_upload_step < p_model->m_num_meshes)
+    {
+        mesh* p_mesh = p_model->m_meshes + load->m_upload_step;
+        upload_mesh_textures(p_mesh, result->m_images, result->m_num_images);
+        setup_mesh(p_mesh);
+    }
+    if (load->m_upload_step + 1 < p_model->m_num_meshes)
+    {
+        return false;
+    }
+    //images some other model uploaded while this one was decoding
+    free_decoded_images(result->m_images, result->m_num_images);
+    set_asset_size(model->m_id, get_freeable_arena_size(&model->m_arena), get_model_gpu_size(p_model));
+    return true;
+}
+
+//the same file on another model binds to another skeleton, so the model is part of the key
+static animation_data* acquire_animation(character* p_character, const char* path, bool* out_created)
+{
+    *out_created = false;
+    model_data* model = (model_data*)get_asset_data(p_character->m_model);
+    if (!model || model->m_model.m_type != ET_CHARACTER)
+    {
+        printf("%s needs a skinned model to play on\n", path);
+        return NULL;
+    }
+    if (p_character->m_num_animation_assets == MAX_ANIMATIONS_PER_CHARACTER)
+    {
+        printf("Too many animations, can not load %s\n", path);
+        return NULL;
+    }
+
+    char key[MAX_ASSET_PATH_LENGTH + 16];
+    snprintf(key, sizeof(key), "%s%c%u", path, ASSET_KEY_SEPARATOR, p_character->m_model);
+    asset_id id = acquire_asset(key, ASSET_TYPE_ANIMATION);
+    if (!id)
+    {
+        return NULL;
+    }
+
+    animation_data* anim = (animation_data*)get_asset_data(id);
+    if (!anim)
+    {
+        anim = create_asset_data<animation_data>(id, "animation");
+        if (!anim)
+        {
+            release_asset(id);
+            return NULL;
+        }
+        //the skeleton has to stay until the channels are bound to it
+        anim->m_model_id = p_character->m_model;
+        retain_asset(anim->m_model_id);
+        *out_created = true;
+    }
+    p_character->m_animation_assets[p_character->m_num_animation_assets++] = id;
+    return anim;
+}
+
+//runs once the model is loaded, its skeleton doesn't change anymore. file is NULL if nothing was read ahead
+static void read_animation_data(animation_data* anim, const char* path, asset_io_request* file)
+{
+    character* p_model = &((model_data*)read_asset_data(anim->m_model_id))->m_model;
+    anim->m_model.m_type           = ET_CHARACTER;
+    anim->m_model.m_skeleton       = p_model->m_skeleton;
+    anim->m_model.m_num_joints     = p_model->m_num_joints;
+    anim->m_model.m_animations     = anim->m_animations;
+    anim->m_model.m_num_animations = 0;
+    read_animation(&anim->m_model, path, &anim->m_arena, anim->m_from_source, file);
+    if (file)
+    {
+        free_asset_io_data(file);
+    }
+}
+
+static void finish_animation_data(animation_data* anim)
+{
+    anim->m_model.m_skeleton = NULL;
+    release_asset(anim->m_model_id);
+    set_asset_size(anim->m_id, get_freeable_arena_size(&anim->m_arena), 0);
+}
+
+static void parse_animation_job(asset_subjob* job)
+{
+    animation_load* read = (animation_load*)job;
+    read_animation_data((animation_data*)job->m_load->m_target, job->m_load->m_path, &read->m_read.m_file);
+}
+
+//a missing animation doesn't fail the load, the character shows up without it
+static bool read_animation_job(asset_load* load)
+{
+    animation_data* anim = (animation_data*)load->m_target;
+    animation_load* read = push_struct<animation_load>(&anim->m_arena);
+    bool baked;
+    if (!read || !get_read_ahead_file(load->m_path, anim->m_from_source, read->m_file, sizeof(read->m_file), &baked))
+    {
+        read_animation_data(anim, load->m_path, NULL);
+        return true;
+    }
+    submit_asset_read(load, &read->m_read, read->m_file, baked ? &anim->m_arena : NULL, &parse_animation_job);
+    return true;
+}
+
+static bool finish_animation_step(asset_load* load)
+{
+    finish_animation_data((animation_data*)load->m_target);
+    return true;
+}
+
+static void attach_animation(character* p_character, asset_id id)
+{
+    //a new model in the meantime dropped the character's animations
+    for (uint32_t i = 0; i < p_character->m_num_animation_assets; ++i)
+    {
+        if (p_character->m_animation_assets[i] == id)
+        {
+            animation_data* anim = (animation_data*)get_asset_data(id);
+            for (uint32_t j = 0; j < anim->m_model.m_num_animations; ++j)
+            {
+                add_character_animation(p_character, anim->m_animations + j);
+            }
+            return;
+        }
+    }
+}
+
+static bool attach_animation_step(asset_load* load)
+{
+    attach_animation((character*)load->m_target, load->m_param);
+    return true;
+}
+
+static void begin_animation_load(character* p_character, animation_data* anim, const char* path, bool created)
+{
+    if (created)
+    {
+        //a model reload in flight waits for the keys read now, these wait for its skeleton instead
+        model_data* model = (model_data*)get_asset_data(p_character->m_model);
+        anim->m_load = begin_asset_load(path, &read_animation_job, &finish_animation_step, anim, 0, model->m_load,
+                                        get_asset_entry(p_character->m_model)->reload);
+    }
+    asset_handle previous = p_character->m_asset;
+    p_character->m_asset = begin_asset_load(path, NULL, &attach_animation_step, p_character, anim->m_id,
+                                            previous, anim->m_load);
+    release_asset_load(previous);
+}
+
+void load_animation_from_file(character* p_character, const char* path)
+{
+    bool created = false;
+    animation_data* anim = acquire_animation(p_character, path, &created);
+    if (!anim)
+    {
+        return;
+    }
+
+    model_data* model = (model_data*)get_asset_data(p_character->m_model);
+    bool model_ready = is_load_finished(model->m_load) && is_asset_ready(p_character->m_asset);
+    if (!model_ready || (!created && !is_load_finished(anim->m_load)))
+    {
+        //the model or the keys are still streaming in, attach once they are there
+        begin_animation_load(p_character, anim, path, created);
+        return;
+    }
+    if (created)
+    {
+        read_animation_data(anim, path, NULL);
+        finish_animation_data(anim);
+    }
+    attach_animation(p_character, anim->m_id);
+}
+
+/*
+    Both return right away, the entity isn't drawn until its latest load is ready. Loads into the
+    same entity run one after the other, an animation needs the skeleton its model brings. Models
+    and animations are read once, entities asking for one that is already there share it.
+*/
+asset_handle load_model_async(entity* p_entity, const char* path, uint32_t num_animations)
+{
+    bool created = false;
+    model_data* model = acquire_model(p_entity, path, &created);
+    if (!model)
+    {
+        return p_entity->m_asset;
+    }
+    if (created)
+    {
+        model->m_num_animations = num_animations;
+        model->m_load = begin_asset_load(path, &read_model_job, &upload_model_step, model, num_animations, 0);
+    }
+    begin_model_attach(p_entity, model, path);
+    return p_entity->m_asset;
+}
+
+asset_handle load_animation_async(character* p_character, const char* path)
+{
+    bool created = false;
+    animation_data* anim = acquire_animation(p_character, path, &created);
+    if (anim)
+    {
+        begin_animation_load(p_character, anim, path, created);
+    }
+    return p_character->m_asset;
+}
+
+/*
+    Hot reload. A changed file is read again on a job thread into data of its own, while the old
+    data stays in use. Once the new data is uploaded, which happens at the start of a frame, the
+    registry entry is pointed at it, everything using the asset is attached again and the old data
+    goes. A reload holds a reference so the old data isn't evicted under it, and reloads of the same
+    asset wait for each other.
+*/
+
+//puts the entity back together from what its assets hold now
+static void reattach_entity(entity* p_entity)
+{
+    model_data* model = (model_data*)get_asset_data(p_entity->m_model);
+    //an entity that is still streaming in attaches on its own once it is there
+    if (!model || !is_asset_ready(p_entity->m_asset))
+    {
+        return;
+    }
+    attach_model(p_entity, model);
+    if (p_entity->m_type != ET_CHARACTER)
+    {
+        return;
+    }
+
+    character* p_character = (character*)p_entity;
+    for (uint32_t i = 0; i < p_character->m_num_animation_assets; ++i)
+    {
+        animation_data* anim = (animation_data*)get_asset_data(p_character->m_animation_assets[i]);
+        //keys bound to a skeleton that changed shape are left out until they are reloaded as well
+        if (anim && is_load_finished(anim->m_load) && anim->m_model.m_num_joints == p_character->m_num_joints)
+        {
+            for (uint32_t j = 0; j < anim->m_model.m_num_animations; ++j)
+            {
+                add_character_animation(p_character, anim->m_animations + j);
+            }
+        }
+    }
+}
+
+static bool uses_asset(entity* p_entity, asset_id id)
+{
+    if (p_entity->m_model == id)
+    {
+        return true;
+    }
+    if (p_entity->m_type == ET_CHARACTER)
+    {
+        character* p_character = (character*)p_entity;
+        for (uint32_t i = 0; i < p_character->m_num_animation_assets; ++i)
+        {
+            if (p_character->m_animation_assets[i] == id)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void reattach_asset_users(asset_id id)
+{
+    for (uint32_t i = 0; i < get_num_characters(); ++i)
+    {
+        character* p_character = get_character_by_index(i);
+        if (uses_asset(p_character, id))
+        {
+            reattach_entity(p_character);
+        }
+    }
+    for (uint32_t i = 0; i < get_num_static_geometries(); ++i)
+    {
+        entity* p_entity = get_static_geometry_by_index(i);
+        if (uses_asset(p_entity, id))
+        {
+            reattach_entity(p_entity);
+        }
+    }
+}
+
+//the source path, without what else went into the key
+static void get_asset_source(asset_id id, char* out_buffer, uint32_t out_size)
+{
+    uint32_t length;
+    const char* key = get_asset_key(id, &length);
+    const char* separator = (const char*)memchr(key, ASSET_KEY_SEPARATOR, length);
+    if (separator)
+    {
+        length = (uint32_t)(separator - key);
+    }
+    snprintf(out_buffer, out_size, "%.*s", (int)length, key);
+}
+
+static void reload_animation(asset_id id, bool from_source);
+
+//the skeleton may have changed, keys bound to it are bound again after it
+static void rebind_animations(asset_id model_id)
+{
+    uint32_t num_assets = get_num_assets();
+    for (asset_id other = 1; other <= num_assets; ++other)
+    {
+        asset_entry* other_entry = get_asset_entry(other);
+        if (other_entry->type == ASSET_TYPE_ANIMATION && other_entry->data &&
+            ((animation_data*)other_entry->data)->m_model_id == model_id)
+        {
+            reload_animation(other, false);
+        }
+    }
+}
+
+/*
+    Keys still being read are bound to the skeleton of the model as it is now, a model reload can't
+    free it under them. Folds every such load into *wait_for with loads that only wait for two
+    others, *out_joined tells whether the caller has to release the handle it ends up with.
+*/
+static bool join_animation_loads(asset_id model_id, const char* path, asset_handle* wait_for, bool* out_joined)
+{
+    uint32_t num_assets = get_num_assets();
+    for (asset_id other = 1; other <= num_assets; ++other)
+    {
+        asset_entry* other_entry = get_asset_entry(other);
+        if (other_entry->type != ASSET_TYPE_ANIMATION || !other_entry->data ||
+            ((animation_data*)other_entry->data)->m_model_id != model_id)
+        {
+            continue;
+        }
+        asset_handle loads[2] = { ((animation_data*)other_entry->data)->m_load, other_entry->reload };
+        for (uint32_t i = 0; i < array_count(loads); ++i)
+        {
+            if (is_load_finished(loads[i]))
+            {
+                continue;
+            }
+            asset_handle joined = begin_asset_load(path, NULL, NULL, NULL, 0, *wait_for, loads[i]);
+            if (*out_joined)
+            {
+                release_asset_load(*wait_for);
+            }
+            if (joined == ASSET_LOAD_FAILED)
+            {
+                *out_joined = false;
+                return false;
+            }
+            *wait_for   = joined;
+            *out_joined = true;
+        }
+    }
+    return true;
+}
+
+static bool swap_model_step(asset_load* load)
+{
+    model_data* model = (model_data*)load->m_target;
+    asset_id id = model->m_id;
+    if (!load->m_result)
+    {
+        printf("Could not reload %s, keeping the old one\n", load->m_path);
+        free_asset_data(&model->m_arena);
+        release_asset(id);
+        return true;
+    }
+    if (!upload_model_step(load))
+    {
+        return false;
+    }
+
+    model_data* old = (model_data*)get_asset_data(id);
+    set_asset_data(id, model, 0);
+    free_model(old);
+    reattach_asset_users(id);
+    rebind_animations(id);
+    release_asset(id);
+    printf("Reloaded %s\n", load->m_path);
+    return true;
+}
+
+static bool swap_animation_step(asset_load* load)
+{
+    animation_data* anim = (animation_data*)load->m_target;
+    asset_id id = anim->m_id;
+    if (anim->m_model.m_num_animations == 0)
+    {
+        printf("Could not reload %s, keeping the old one\n", load->m_path);
+        release_asset(anim->m_model_id);
+        free_asset_data(&anim->m_arena);
+        release_asset(id);
+        return true;
+    }
+    finish_animation_data(anim);
+
+    animation_data* old = (animation_data*)get_asset_data(id);
+    set_asset_data(id, anim, 0);
+    release_asset_load(old->m_load);
+    free_asset_data(&old->m_arena);
+    reattach_asset_users(id);
+    release_asset(id);
+    printf("Reloaded %s\n", load->m_path);
+    return true;
+}
+
+/*
+    The entry keeps its newest reload only so the next one waits for it, it doesn't hold the load.
+    The handle reads as done once the reload's slot is reused.
+*/
+static void set_reload_handle(asset_entry* entry, asset_handle handle)
+{
+    release_asset_load(handle);
+    entry->reload = handle;
+}
+
+//an asset that isn't loaded, or is still streaming in, is read from the new file anyway
+static void reload_animation(asset_id id, bool from_source)
+{
+    animation_data* old = (animation_data*)get_asset_data(id);
+    if (!old || !is_load_finished(old->m_load))
+    {
+        return;
+    }
+    //without its model nothing plays it, it is bound again when the model is back
+    asset_entry* model_entry = get_asset_entry(old->m_model_id);
+    if (!model_entry->data)
+    {
+        return;
+    }
+
+    animation_data* anim = alloc_asset_data<animation_data>(id, "animation");
+    if (!anim)
+    {
+        return;
+    }
+    anim->m_model_id    = old->m_model_id;
+    anim->m_from_source = from_source;
+    retain_asset(id);
+    retain_asset(anim->m_model_id);
+
+    char path[MAX_ASSET_PATH_LENGTH];
+    get_asset_source(id, path, sizeof(path));
+    asset_entry* entry = get_asset_entry(id);
+    //a model reload in flight brings the skeleton the keys are bound to
+    asset_handle handle = begin_asset_load(path, &read_animation_job, &swap_animation_step, anim, 0,
+                                           entry->reload, model_entry->reload);
+    if (handle == ASSET_LOAD_FAILED)
+    {
+        release_asset(anim->m_model_id);
+        release_asset(id);
+        free_asset_data(&anim->m_arena);
+        return;
+    }
+    set_reload_handle(entry, handle);
+}
+
+static void reload_model(asset_id id, bool from_source)
+{
+    model_data* old = (model_data*)get_asset_data(id);
+    if (!old || !is_load_finished(old->m_load))
+    {
+        return;
+    }
+
+    model_data* model = alloc_asset_data<model_data>(id, "model");
+    if (!model)
+    {
+        return;
+    }
+    model->m_model.m_type   = old->m_model.m_type;
+    model->m_num_animations = old->m_num_animations;
+    model->m_from_source    = from_source;
+    model->m_reload         = true;
+    retain_asset(id);
+
+    char path[MAX_ASSET_PATH_LENGTH];
+    get_asset_source(id, path, sizeof(path));
+    asset_entry* entry = get_asset_entry(id);
+    asset_handle wait_for = entry->reload;
+    bool joined = false;
+    if (!join_animation_loads(id, path, &wait_for, &joined))
+    {
+        release_asset(id);
+        free_asset_data(&model->m_arena);
+        return;
+    }
+    asset_handle handle = begin_asset_load(path, &read_model_job, &swap_model_step, model,
+                                           model->m_num_animations, wait_for);
+    if (joined)
+    {
+        release_asset_load(wait_for);
+    }
+    if (handle == ASSET_LOAD_FAILED)
+    {
+        release_asset(id);
+        free_asset_data(&model->m_arena);
+        return;
+    }
+    set_reload_handle(entry, handle);
+}
+
+//decoded on a job thread, malloced since it only lives until the upload
+struct texture_reload
+{
+    decoded_image m_image;
+    asset_id      m_id;
+    bool          m_from_source;
+};
+
+static bool decode_texture_job(asset_load* load)
+{
+    texture_reload* reload = (texture_reload*)load->m_target;
+    decoded_image* image = &reload->m_image;
+    image->m_path  = intern_string(load->m_path);
+    image->m_baked = get_image_file(load->m_path, reload->m_from_source, image->m_file, sizeof(image->m_file));
+    submit_asset_read(load, &image->m_read, image->m_file, NULL, &decode_image_job);
+    return true;
+}
+
+//the same GL texture gets the new texels, every mesh sharing it draws them from now on
+static bool swap_texture_step(asset_load* load)
+{
+    texture_reload* reload = (texture_reload*)load->m_target;
+    decoded_image* image = &reload->m_image;
+    uint32_t texture_id = get_asset_entry(reload->m_id)->gpu_name;
+
+    if (image->m_data)
+    {
+        //a baked texture capped the levels to the ones it brought
+        glBindTexture(GL_TEXTURE_2D, texture_id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+        uint64_t gpu_size = image->m_baked ?
+            upload_mip_texture(texture_id, (const mip_texture_header*)image->m_data) :
+            upload_texture(texture_id, image->m_data, image->m_width, image->m_height, image->m_num_components);
+        set_asset_size(reload->m_id, 0, gpu_size);
+        printf("Reloaded %s\n", load->m_path);
+    }
+    else
+    {
+        printf("Could not reload %s, keeping the old one\n", load->m_path);
+    }
+    free_decoded_image(image);
+    release_asset(reload->m_id);
+    free(reload);
+    return true;
+}
+
+static void reload_texture(asset_id id, bool from_source)
+{
+    asset_entry* entry = get_asset_entry(id);
+    if (!entry->gpu_name)
+    {
+        return;
+    }
+
+    texture_reload* reload = (texture_reload*)malloc(sizeof(texture_reload));
+    memset(reload, 0, sizeof(texture_reload));
+    reload->m_id          = id;
+    reload->m_from_source = from_source;
+    retain_asset(id);
+
+    char path[MAX_ASSET_PATH_LENGTH];
+    get_asset_source(id, path, sizeof(path));
+    asset_handle handle = begin_asset_load(path, &decode_texture_job, &swap_texture_step, reload, id, entry->reload);
+    if (handle == ASSET_LOAD_FAILED)
+    {
+        release_asset(id);
+        free(reload);
+        return;
+    }
+    set_reload_handle(entry, handle);
+}
+
+static bool has_extension(const char* path, const char* extension)
+{
+    size_t length = strlen(path);
+    size_t extension_length = strlen(extension);
+    return length >= extension_length && strcmp(path + length - extension_length, extension) == 0;
+}
+
+//the length without the extension, if there is one after the last slash
+static size_t get_stem_length(const char* path, size_t length)
+{
+    for (size_t i = length; i > 0; --i)
+    {
+        if (path[i - 1] == '/')
+        {
+            break;
+        }
+        if (path[i - 1] == '.')
+        {
+            return i - 1;
+        }
+    }
+    return length;
+}
+
+void reload_changed_asset(const char* path)
+{
+    //a rebaked file is picked up the usual way, it only has to match the source by name
+    bool baked_texture = has_extension(path, MIP_TEXTURE_EXTENSION);
+    bool baked = baked_texture || has_extension(path, BAKED_ASSET_EXTENSION);
+    size_t path_length = strlen(path);
+    if (baked)
+    {
+        path_length = get_stem_length(path, path_length);
+    }
+
+    uint32_t num_assets = get_num_assets();
+    for (asset_id id = 1; id <= num_assets; ++id)
+    {
+        asset_entry* entry = get_asset_entry(id);
+        char source[MAX_ASSET_PATH_LENGTH];
+        get_asset_source(id, source, sizeof(source));
+        size_t source_length = baked ? get_stem_length(source, strlen(source)) : strlen(source);
+        if (source_length != path_length || memcmp(source, path, path_length) != 0 ||
+            (baked && baked_texture != (entry->type == ASSET_TYPE_TEXTURE)))
+        {
+            continue;
+        }
+
+        switch (entry->type)
+        {
+            case ASSET_TYPE_MESH:
+                reload_model(id, !baked);
+                break;
+            case ASSET_TYPE_TEXTURE:
+                reload_texture(id, !baked);
+                break;
+            case ASSET_TYPE_ANIMATION:
+                reload_animation(id, !baked);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void draw_mesh(mesh* p_mesh, shader s)
+{
+    uint32_t diffuse_nr  = 1;
     uint32_t specular_nr = 1;
     uint32_t normal_nr   = 1;
     uint32_t height_nr   = 1;
@@ -854,30 +2419,33 @@ void draw_mesh(mesh* p_mesh, shader s)
 
         glActiveTexture(GL_TEXTURE0 + i);
 
-        char texture_name[MAX_ASSET_PATH_LENGTH];
-        char number[2];
-        memset(texture_name, 0, MAX_ASSET_PATH_LENGTH);
-        memset(number, 0, 2);
-        strcpy(texture_name, text->m_type);
-
-        if(strcmp(texture_name, "texture_diffuse") == 0)
+        uint32_t number = 0;
+        if(text->m_type == m_texture_diffuse)
+        {
+            number = diffuse_nr++;
+        }
+        else if(text->m_type == m_texture_specular)
         {
-            number[0] = (diffuse_nr++) + '0';
+            number = specular_nr++;
         }
-        else if(strcmp(texture_name, "texture_specular") == 0)
+        else if(text->m_type == m_texture_normal)
         {
-            number[0] = (specular_nr++) + '0';
+            number = normal_nr++;
         }
-        else if(strcmp(texture_name, "texture_normal") == 0)
+        else if(text->m_type == m_texture_height)
         {
-            number[0] = (normal_nr++) + '0';
+            number = height_nr++;
         }
-        else if(strcmp(texture_name, "texture_height") == 0)
+        //e.g. texture_diffuse1
+        char texture_name[MAX_ASSET_PATH_LENGTH];
+        if (number)
+        {
+            snprintf(texture_name, sizeof(texture_name), "%s%u", get_string(text->m_type), number);
+        }
+        else
         {
-            number[0] = (height_nr++) + '0';
+            snprintf(texture_name, sizeof(texture_name), "%s", get_string(text->m_type));
         }
-        number[1] = '\0';
-        strcat(texture_name, number);
         glUniform1i(glGetUniformLocation(s.id, texture_name), i);
         glBindTexture(GL_TEXTURE_2D, text->id);
     }
@@ -13,15 +13,21 @@
 #include <assimp/postprocess.h>
 
 #include "asset.h"
+#include "asset_stream.h"
 #include "math.h"
 #include "memory.h"
 #include "hash.h"
 #include "common.h"
 #include "shader.h"
+#include "string_table.h"
 
 #define MAX_BONE_INFLUENCE      4
 #define MAX_BONE_NAME_LEN       64
 #define MAX_NUM_BONES           128
+#define MESH_MEMORY_BUDGET      Megabytes(512)
+#define ANIMATION_MEMORY_BUDGET Megabytes(256)
+//post processing every source goes through, the import cache is keyed by it as well
+#define MODEL_IMPORT_FLAGS      (aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace)
 
 struct entity;
 struct character;
@@ -47,7 +53,7 @@ struct scale_key
 //transformations of a single bone
 struct anim_node
 {
-    char* node_name;
+    string_id  node_name;
     quat_key*  m_rotation_keys;
     pos_key*   m_position_keys;
     scale_key* m_scale_keys;
@@ -86,16 +92,17 @@ struct vertex
 
 struct texture
 {
-    char*    m_path;
-    char*    m_type;
-    uint32_t id;
+    string_id m_path;
+    string_id m_type;  //"texture_diffuse", "texture_specular"...
+    uint32_t  id;
+    asset_id  m_asset; //shared GL texture, 0 until uploaded
 };
 
 struct joint
 {
     glm::mat4   m_transformation;
     glm::mat4   m_offset;
-    char*       m_name;
+    string_id   m_name;
     uint8_t     m_parent;
 };
 
@@ -120,16 +127,38 @@ struct skeleton_load_result
     uint32_t m_num_joints;
 };
 
+//where an import puts its data, every import has its own so several can run on job threads at once
+struct model_import
+{
+    memory_arena* m_mesh_arena;
+    memory_arena* m_animation_arena;
+    char          m_directory[MAX_ASSET_PATH_LENGTH];
+};
+
 
 bool      get_pause_anim(void);
 void      set_pause_anim(bool pause);
 void      set_bone_transforms(character* p_character);
 void      get_bone_transforms(character* p_character, float dt, uint32_t anim_index_1, uint32_t anim_index_2, float blend_factor);
 uint32_t  load_texture_from_file(const char* texture_name, bool gamma);
-void      load_material_textures(mesh* p_mesh, aiMaterial* mat, aiTextureType type, const char* path);
-void      get_directory_name(const char* in_buffer, char* out_buffer, uint8_t character);
+void      load_material_textures(mesh* p_mesh, aiMaterial* mat, aiTextureType type, string_id type_name, model_import* import);
+void      get_directory_name(const char* in_buffer, char* out_buffer, uint32_t out_size, uint8_t character);
 void      load_model_from_file(entity* p_entity, const char* path, uint32_t num_animations);
 void      load_animation_from_file(character* p_character, const char* path);
+asset_handle load_model_async(entity* p_entity, const char* path, uint32_t num_animations);
+asset_handle load_animation_async(character* p_character, const char* path);
+bool      import_model(entity* p_entity, const char* path, uint32_t num_animations);
+bool      import_model(entity* p_entity, const char* path, uint32_t num_animations, memory_arena* mesh_arena,
+                       memory_arena* animation_arena, const asset_io_request* source = NULL);
+bool      import_animation(character* p_character, const char* path);
+bool      import_animation(character* p_character, const char* path, memory_arena* arena, const asset_io_request* source = NULL);
+void      upload_model(entity* p_entity);
+//drops the entity's model and animations, unused ones stay loaded until they are evicted
+void      release_entity_assets(entity* p_entity);
+//re-reads whatever was loaded from the file, see asset_watch.h. Main thread
+void      reload_changed_asset(const char* path);
+uint8_t   find_bone(character* p_character, string_id name);
+uint8_t   find_bone_by_name(character* p_character, const char* name);
 void      mesh_component_init(void);
 void      setup_mesh(mesh* p_mesh);
 void      draw_mesh(mesh* p_mesh, shader s);
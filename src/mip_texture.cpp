@@ -0,0 +1,144 @@
+#include "mip_texture.h"
+
+#include <stdio.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_TEXTURE_SSE2
+#endif
+
+static inline uint64_t align_mip_offset(uint64_t offset)
+{
+    return (offset + MIP_TEXTURE_ALIGNMENT - 1) & ~(uint64_t)(MIP_TEXTURE_ALIGNMENT - 1);
+}
+
+uint32_t get_mip_level_count(uint32_t width, uint32_t height)
+{
+    uint32_t largest = width > height ? width : height;
+    uint32_t result = 1;
+    while (largest > 1 && result < MAX_MIP_LEVELS)
+    {
+        largest >>= 1;
+        result++;
+    }
+    return result;
+}
+
+/*
+    A side of 1 can't be halved, its texels are averaged with themselves. Four component rows go
+    through SSE2 two destination texels at a time, the tail and other formats are done one by one.
+*/
+void downsample_mip_level(const uint8_t* src, uint32_t width, uint32_t height, uint32_t num_components, uint8_t* dst)
+{
+    uint32_t dst_width  = get_mip_level_size(width, 1);
+    uint32_t dst_height = get_mip_level_size(height, 1);
+    uint64_t pitch      = (uint64_t)width * num_components;
+
+    for (uint32_t y = 0; y < dst_height; ++y)
+    {
+        const uint8_t* row_0 = src + (uint64_t)(2 * y) * pitch;
+        const uint8_t* row_1 = (2 * y + 1 < height) ? row_0 + pitch : row_0;
+        uint8_t* out = dst + (uint64_t)y * dst_width * num_components;
+        uint32_t x = 0;
+
+#ifdef MIP_TEXTURE_SSE2
+        if (num_components == 4 && width > 1)
+        {
+            const __m128i zero  = _mm_setzero_si128();
+            const __m128i round = _mm_set1_epi16(2);
+            for (; x + 2 <= dst_width; x += 2)
+            {
+                __m128i a = _mm_loadu_si128((const __m128i*)(row_0 + 8 * x));
+                __m128i b = _mm_loadu_si128((const __m128i*)(row_1 + 8 * x));
+                //columns summed as 16 bit, texels 0 and 1 in lo, 2 and 3 in hi
+                __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+                sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+                _mm_storel_epi64((__m128i*)(out + 4 * x), _mm_packus_epi16(sum, zero));
+            }
+        }
+#endif
+        for (; x < dst_width; ++x)
+        {
+            uint64_t x_0 = (uint64_t)(2 * x) * num_components;
+            uint64_t x_1 = (2 * x + 1 < width) ? x_0 + num_components : x_0;
+            for (uint32_t c = 0; c < num_components; ++c)
+            {
+                uint32_t sum = row_0[x_0 + c] + row_0[x_1 + c] + row_1[x_0 + c] + row_1[x_1 + c];
+                out[(uint64_t)x * num_components + c] = (uint8_t)((sum + 2) >> 2);
+            }
+        }
+    }
+}
+
+uint8_t* build_mip_texture(const uint8_t* texels, uint32_t width, uint32_t height, uint32_t num_components,
+                           memory_arena* arena, uint64_t* out_size)
+{
+    if (width == 0 || height == 0 || num_components == 0 || num_components > 4)
+    {
+        return NULL;
+    }
+
+    mip_texture_header header = {};
+    header.magic          = MIP_TEXTURE_MAGIC;
+    header.version        = MIP_TEXTURE_VERSION;
+    header.width          = width;
+    header.height         = height;
+    header.num_components = num_components;
+    header.num_levels     = get_mip_level_count(width, height);
+
+    uint64_t offset = align_mip_offset(sizeof(mip_texture_header));
+    for (uint32_t level = 0; level < header.num_levels; ++level)
+    {
+        header.level_offsets[level] = offset;
+        offset = align_mip_offset(offset + (uint64_t)get_mip_level_size(width, level) *
+                                  get_mip_level_size(height, level) * num_components);
+    }
+    header.file_size = offset;
+
+    uint8_t* result = (uint8_t*)push_size(arena, header.file_size, CACHE_LINE_SIZE);
+    if (!result)
+    {
+        return NULL;
+    }
+    //padding included, the same image always bakes to the same bytes
+    memset(result, 0, header.file_size);
+    memcpy(result, &header, sizeof(header));
+    memcpy(result + header.level_offsets[0], texels, (uint64_t)width * height * num_components);
+
+    for (uint32_t level = 1; level < header.num_levels; ++level)
+    {
+        downsample_mip_level(result + header.level_offsets[level - 1],
+                             get_mip_level_size(width, level - 1), get_mip_level_size(height, level - 1),
+                             num_components, result + header.level_offsets[level]);
+    }
+
+    *out_size = header.file_size;
+    return result;
+}
+
+const mip_texture_header* validate_mip_texture(const void* data, uint64_t size, const char* name)
+{
+    const mip_texture_header* header = (const mip_texture_header*)data;
+    bool valid = size >= sizeof(mip_texture_header) &&
+                 header->magic == MIP_TEXTURE_MAGIC && header->version == MIP_TEXTURE_VERSION &&
+                 header->file_size == size && header->width != 0 && header->height != 0 &&
+                 header->num_components != 0 && header->num_components <= 4 &&
+                 header->num_levels != 0 && header->num_levels <= get_mip_level_count(header->width, header->height);
+
+    for (uint32_t level = 0; valid && level < header->num_levels; ++level)
+    {
+        uint64_t offset     = header->level_offsets[level];
+        uint64_t level_size = (uint64_t)get_mip_level_size(header->width, level) *
+                              get_mip_level_size(header->height, level) * header->num_components;
+        valid = (offset % MIP_TEXTURE_ALIGNMENT) == 0 && offset <= size && level_size <= size - offset;
+    }
+
+    if (!valid)
+    {
+        printf("%s is not a mip texture of this version, rebake it\n", name);
+        return NULL;
+    }
+    return header;
+}
@@ -0,0 +1,46 @@
+#ifndef MIP_TEXTURE_H
+#define MIP_TEXTURE_H
+
+#include <stdint.h>
+
+#include "memory.h"
+
+/*
+    Baked texture with its whole mip chain, written by the asset baker next to the image (and into
+    the pack) so the game uploads every level as it is instead of decoding and calling glGenerateMipmap.
+    Levels are tightly packed 8 bit texels, level 0 is full size and every next one is half of the one
+    before, down to 1x1. Level offsets are from the start of the header.
+*/
+#define MIP_TEXTURE_MAGIC     0x58455446 //'FTEX'
+#define MIP_TEXTURE_VERSION   1
+#define MIP_TEXTURE_ALIGNMENT 16
+#define MIP_TEXTURE_EXTENSION ".ftex"
+#define MAX_MIP_LEVELS        16
+
+struct mip_texture_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t num_components;
+    uint32_t num_levels;
+    uint64_t file_size;
+    uint64_t level_offsets[MAX_MIP_LEVELS];
+};
+
+uint32_t get_mip_level_count(uint32_t width, uint32_t height);
+inline uint32_t get_mip_level_size(uint32_t size, uint32_t level)
+{
+    return (size >> level) ? (size >> level) : 1;
+}
+
+//2x2 box filter, one level down
+void     downsample_mip_level(const uint8_t* src, uint32_t width, uint32_t height, uint32_t num_components, uint8_t* dst);
+//header and every level in one blob pushed onto the arena, NULL if it doesn't fit
+uint8_t* build_mip_texture(const uint8_t* texels, uint32_t width, uint32_t height, uint32_t num_components,
+                           memory_arena* arena, uint64_t* out_size);
+//NULL unless data holds a whole, consistent mip texture
+const mip_texture_header* validate_mip_texture(const void* data, uint64_t size, const char* name);
+
+#endif
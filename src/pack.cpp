@@ -0,0 +1,525 @@
+#include "pack.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <cassert>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <thread>
+
+#include "asset.h"
+#include "compress.h"
+#include "memory.h"
+#include "thread.h"
+
+static uint8_t*    pack_base;
+static uint64_t    pack_size;
+static pack_entry* pack_toc;
+static uint32_t    pack_toc_size;
+#ifdef _WIN32
+static HANDLE      pack_file_handle;
+static HANDLE      pack_mapping_handle;
+#endif
+
+static uint8_t* platform_map_file(const char* path, uint64_t* out_size)
+{
+#ifdef _WIN32
+    pack_file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (pack_file_handle == INVALID_HANDLE_VALUE)
+    {
+        return NULL;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(pack_file_handle, &size);
+    pack_mapping_handle = CreateFileMappingA(pack_file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!pack_mapping_handle)
+    {
+        CloseHandle(pack_file_handle);
+        return NULL;
+    }
+    void* result = MapViewOfFile(pack_mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    *out_size = (uint64_t)size.QuadPart;
+    return (uint8_t*)result;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    //shared and read only, every process mapping the pack uses the same page cache pages
+    void* result = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (result == MAP_FAILED)
+    {
+        return NULL;
+    }
+    *out_size = (uint64_t)st.st_size;
+    return (uint8_t*)result;
+#endif
+}
+
+static void platform_unmap_file(uint8_t* base, uint64_t size)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(pack_mapping_handle);
+    CloseHandle(pack_file_handle);
+#else
+    munmap(base, (size_t)size);
+#endif
+}
+
+bool pack_open(const char* path)
+{
+    uint64_t size = 0;
+    uint8_t* base = platform_map_file(path, &size);
+    if (!base)
+    {
+        return false;
+    }
+
+    pack_header* header = (pack_header*)base;
+    bool valid = size >= sizeof(pack_header) &&
+                 header->magic == PACK_MAGIC && header->version == PACK_VERSION &&
+                 header->file_size == size &&
+                 header->toc_size != 0 && (header->toc_size & (header->toc_size - 1)) == 0 &&
+                 header->num_entries < header->toc_size &&
+                 header->toc_offset <= size && header->toc_size <= (size - header->toc_offset) / sizeof(pack_entry);
+    if (!valid)
+    {
+        printf("%s is not a pack file of this version\n", path);
+        platform_unmap_file(base, size);
+        return false;
+    }
+
+    pack_base     = base;
+    pack_size     = size;
+    pack_toc      = (pack_entry*)(base + header->toc_offset);
+    pack_toc_size = header->toc_size;
+    printf("Mapped pack %s: %u assets, %llu bytes\n", path, header->num_entries, (unsigned long long)size);
+    return true;
+}
+
+void pack_close(void)
+{
+    if (pack_base)
+    {
+        platform_unmap_file(pack_base, pack_size);
+        pack_base     = NULL;
+        pack_size     = 0;
+        pack_toc      = NULL;
+        pack_toc_size = 0;
+    }
+}
+
+static pack_entry* find_pack_entry(uint64_t hash, pack_entry_type type)
+{
+    if (!pack_base)
+    {
+        return NULL;
+    }
+
+    //a damaged table may have no empty slot left to stop at, so no more than one lap
+    uint32_t mask = pack_toc_size - 1;
+    uint32_t index = (uint32_t)hash & mask;
+    for (uint32_t probe = 0; probe < pack_toc_size && pack_toc[index].hash != 0; ++probe, index = (index + 1) & mask)
+    {
+        pack_entry* entry = pack_toc + index;
+        if (entry->hash != hash)
+        {
+            continue;
+        }
+        if (entry->type != (uint32_t)type || entry->offset > pack_size || entry->stored_size > pack_size - entry->offset)
+        {
+            return NULL;
+        }
+        if (!(entry->flags & PACK_ENTRY_COMPRESSED) && entry->stored_size != entry->size)
+        {
+            return NULL;
+        }
+        return entry;
+    }
+    return NULL;
+}
+
+bool pack_contains(const char* asset_path, pack_entry_type type)
+{
+    return find_pack_entry(asset_path_hash(asset_path), type) != NULL;
+}
+
+/*
+    A compressed entry being loaded. The loading thread hands it to helper jobs and decompresses
+    blocks itself too, blocks are claimed one at a time so nobody waits on a helper that hasn't
+    started yet: a helper that only runs once everything is done finds nothing left and lets go.
+    The slot is free again once the load and every helper let go of it.
+*/
+struct pack_decompression
+{
+    const uint32_t*       block_ends;
+    const uint8_t*        blocks;
+    uint8_t*              dest;
+    uint64_t              size;
+    uint32_t              num_blocks;
+    std::atomic<uint32_t> next_block;
+    std::atomic<uint32_t> num_finished;
+    std::atomic<uint32_t> num_failed;
+    std::atomic<uint32_t> refs; //0 when the slot is free
+};
+
+static pack_decompression pack_decompressions[MAX_PACK_DECOMPRESSIONS];
+
+static bool decompress_pack_block(const uint32_t* block_ends, const uint8_t* blocks, uint8_t* dest, uint64_t size, uint32_t index)
+{
+    uint64_t begin       = index ? block_ends[index - 1] : 0;
+    uint64_t stored_size = block_ends[index] - begin;
+    uint64_t offset      = (uint64_t)index * PACK_BLOCK_SIZE;
+    uint64_t block_size  = size - offset < PACK_BLOCK_SIZE ? size - offset : PACK_BLOCK_SIZE;
+    if (stored_size == block_size)
+    {
+        memcpy(dest + offset, blocks + begin, block_size);
+        return true;
+    }
+    return decompress_block(blocks + begin, stored_size, dest + offset, block_size);
+}
+
+static void decompress_pack_blocks(pack_decompression* decompression)
+{
+    for (;;)
+    {
+        uint32_t index = decompression->next_block.fetch_add(1);
+        if (index >= decompression->num_blocks)
+        {
+            return;
+        }
+        if (!decompress_pack_block(decompression->block_ends, decompression->blocks, decompression->dest,
+                                   decompression->size, index))
+        {
+            decompression->num_failed.fetch_add(1);
+        }
+        decompression->num_finished.fetch_add(1, std::memory_order_release);
+    }
+}
+
+static void pack_decompression_job(void* arg)
+{
+    pack_decompression* decompression = (pack_decompression*)arg;
+    decompress_pack_blocks(decompression);
+    decompression->refs.fetch_sub(1, std::memory_order_release);
+}
+
+static pack_decompression* begin_pack_decompression(void)
+{
+    for (uint32_t i = 0; i < MAX_PACK_DECOMPRESSIONS; ++i)
+    {
+        uint32_t free_slot = 0;
+        if (pack_decompressions[i].refs.load(std::memory_order_acquire) == 0 &&
+            pack_decompressions[i].refs.compare_exchange_strong(free_slot, 1, std::memory_order_acquire))
+        {
+            return pack_decompressions + i;
+        }
+    }
+    return NULL;
+}
+
+//the block table was checked, every block end is inside the entry and none comes before the last
+static bool decompress_pack_entry(const uint32_t* block_ends, const uint8_t* blocks, uint32_t num_blocks,
+                                  uint8_t* dest, uint64_t size)
+{
+    pack_decompression* decompression = num_blocks > 1 ? begin_pack_decompression() : NULL;
+    if (!decompression)
+    {
+        //one block, or every slot is busy with other loads
+        for (uint32_t i = 0; i < num_blocks; ++i)
+        {
+            if (!decompress_pack_block(block_ends, blocks, dest, size, i))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    decompression->block_ends = block_ends;
+    decompression->blocks     = blocks;
+    decompression->dest       = dest;
+    decompression->size       = size;
+    decompression->num_blocks = num_blocks;
+    decompression->next_block.store(0);
+    decompression->num_finished.store(0);
+    decompression->num_failed.store(0);
+
+    uint32_t num_helpers = num_blocks - 1 < NUM_THREADS ? num_blocks - 1 : NUM_THREADS;
+    decompression->refs.fetch_add(num_helpers);
+    for (uint32_t i = 0; i < num_helpers; ++i)
+    {
+        thread_job job = {&pack_decompression_job, decompression, NULL};
+        submit_job(job);
+    }
+
+    decompress_pack_blocks(decompression);
+    //only blocks a helper already claimed are left, they are being worked on right now
+    while (decompression->num_finished.load(std::memory_order_acquire) < num_blocks)
+    {
+        std::this_thread::yield();
+    }
+    bool ok = decompression->num_failed.load() == 0;
+    decompression->refs.fetch_sub(1, std::memory_order_release);
+    return ok;
+}
+
+const void* pack_load_by_hash(uint64_t hash, pack_entry_type type, memory_arena* arena, uint64_t* out_size)
+{
+    pack_entry* entry = find_pack_entry(hash, type);
+    if (!entry)
+    {
+        return NULL;
+    }
+    const uint8_t* stored = pack_base + entry->offset;
+    if (!(entry->flags & PACK_ENTRY_COMPRESSED))
+    {
+        *out_size = entry->size;
+        return stored;
+    }
+
+    uint64_t num_blocks = (entry->size + PACK_BLOCK_SIZE - 1) / PACK_BLOCK_SIZE;
+    uint64_t table_size = num_blocks * sizeof(uint32_t);
+    if (num_blocks == 0 || table_size > entry->stored_size)
+    {
+        printf("Pack entry %016llx has a broken block table\n", (unsigned long long)hash);
+        return NULL;
+    }
+    const uint32_t* block_ends = (const uint32_t*)stored;
+    uint64_t previous_end = 0;
+    for (uint64_t i = 0; i < num_blocks; ++i)
+    {
+        if (block_ends[i] < previous_end || block_ends[i] > entry->stored_size - table_size)
+        {
+            printf("Pack entry %016llx has a broken block table\n", (unsigned long long)hash);
+            return NULL;
+        }
+        previous_end = block_ends[i];
+    }
+
+    uint8_t* dest = arena ? (uint8_t*)push_size(arena, entry->size, PACK_ALIGNMENT) : (uint8_t*)malloc(entry->size);
+    if (!dest)
+    {
+        printf("Out of memory decompressing pack entry %016llx\n", (unsigned long long)hash);
+        return NULL;
+    }
+    if (!decompress_pack_entry(block_ends, stored + table_size, (uint32_t)num_blocks, dest, entry->size))
+    {
+        printf("Pack entry %016llx doesn't decompress\n", (unsigned long long)hash);
+        //arena memory is only given back with the arena
+        if (!arena)
+        {
+            free(dest);
+        }
+        return NULL;
+    }
+    *out_size = entry->size;
+    return dest;
+}
+
+const void* pack_load(const char* asset_path, pack_entry_type type, memory_arena* arena, uint64_t* out_size)
+{
+    return pack_load_by_hash(asset_path_hash(asset_path), type, arena, out_size);
+}
+
+void pack_free(const void* data)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    if (bytes && (bytes < pack_base || bytes >= pack_base + pack_size))
+    {
+        free((void*)data);
+    }
+}
+
+static void free_compressed_entries(uint8_t** compressed, uint32_t num_entries)
+{
+    for (uint32_t i = 0; i < num_entries; ++i)
+    {
+        free(compressed[i]);
+    }
+}
+
+static inline uint64_t align_pack_offset(uint64_t offset)
+{
+    return (offset + PACK_ALIGNMENT - 1) & ~(uint64_t)(PACK_ALIGNMENT - 1);
+}
+
+static bool write_pack_padding(FILE* file, uint64_t* offset, uint64_t target)
+{
+    static const uint8_t zeroes[PACK_ALIGNMENT] = {};
+    uint64_t padding = target - *offset;
+    *offset = target;
+    return padding == 0 || fwrite(zeroes, 1, padding, file) == padding;
+}
+
+/*
+    Block table and blocks, malloced. NULL if the entry is empty or doesn't save enough to be worth
+    decompressing, it is stored as it is then.
+*/
+static uint8_t* compress_pack_entry(const pack_source* source, uint64_t* out_stored_size)
+{
+    uint64_t num_blocks = (source->size + PACK_BLOCK_SIZE - 1) / PACK_BLOCK_SIZE;
+    uint64_t table_size = num_blocks * sizeof(uint32_t);
+    uint64_t max_stored = source->size - source->size / PACK_MIN_SAVING;
+    if (num_blocks == 0 || table_size >= max_stored)
+    {
+        return NULL;
+    }
+
+    uint8_t* result = (uint8_t*)malloc(table_size + num_blocks * compress_bound(PACK_BLOCK_SIZE));
+    if (!result)
+    {
+        return NULL;
+    }
+    uint32_t* block_ends = (uint32_t*)result;
+    uint8_t* blocks = result + table_size;
+    const uint8_t* data = (const uint8_t*)source->data;
+    uint64_t stored = 0;
+    for (uint64_t i = 0; i < num_blocks; ++i)
+    {
+        uint64_t offset     = i * PACK_BLOCK_SIZE;
+        uint64_t block_size = source->size - offset < PACK_BLOCK_SIZE ? source->size - offset : PACK_BLOCK_SIZE;
+        uint64_t compressed = compress_block(data + offset, block_size, blocks + stored, compress_bound(block_size));
+        if (compressed == 0 || compressed >= block_size)
+        {
+            //a stored size of the full block size means it is kept as it is
+            memcpy(blocks + stored, data + offset, block_size);
+            compressed = block_size;
+        }
+        stored += compressed;
+        block_ends[i] = (uint32_t)stored;
+    }
+
+    if (table_size + stored > max_stored)
+    {
+        free(result);
+        return NULL;
+    }
+    *out_stored_size = table_size + stored;
+    return result;
+}
+
+/*
+    The table is kept at most half full, so a lookup for a missing asset stops quickly.
+    Entries are aligned to PACK_ALIGNMENT so in place data keeps the alignment the loaders expect.
+    Compression runs first, the layout needs the stored sizes.
+*/
+bool write_pack(const char* path, pack_source* sources, uint32_t num_sources)
+{
+    uint32_t toc_size = 16;
+    while (toc_size < num_sources * 2)
+    {
+        toc_size *= 2;
+    }
+
+    memory_arena* scratch = get_scratch_arena();
+    temporary_memory temp = begin_temporary_memory(scratch);
+    pack_entry* toc = push_array<pack_entry>(scratch, toc_size);
+    pack_source** ordered = push_array<pack_source*>(scratch, num_sources);
+    uint8_t** compressed = push_array<uint8_t*>(scratch, num_sources);
+    uint64_t* stored_sizes = push_array<uint64_t>(scratch, num_sources);
+    if (!toc || !ordered || !compressed || !stored_sizes)
+    {
+        end_temporary_memory(temp);
+        return false;
+    }
+    memset(toc, 0, toc_size * sizeof(pack_entry));
+    memset(compressed, 0, num_sources * sizeof(uint8_t*));
+
+    pack_header header = {};
+    header.magic      = PACK_MAGIC;
+    header.version    = PACK_VERSION;
+    header.toc_size   = toc_size;
+    header.toc_offset = align_pack_offset(sizeof(pack_header));
+
+    uint64_t offset = header.toc_offset + toc_size * sizeof(pack_entry);
+    uint64_t total_size = 0;
+    uint32_t num_entries = 0;
+    for (uint32_t i = 0; i < num_sources; ++i)
+    {
+        uint64_t hash = asset_path_hash(sources[i].path);
+        uint32_t index = (uint32_t)hash & (toc_size - 1);
+        while (toc[index].hash != 0 && toc[index].hash != hash)
+        {
+            index = (index + 1) & (toc_size - 1);
+        }
+        if (toc[index].hash == hash)
+        {
+            printf("%s is in the pack twice, keeping the first one\n", sources[i].path);
+            continue;
+        }
+
+        uint64_t stored_size = sources[i].size;
+        compressed[num_entries] = compress_pack_entry(sources + i, &stored_size);
+        stored_sizes[num_entries] = stored_size;
+
+        offset = align_pack_offset(offset);
+        toc[index].hash        = hash;
+        toc[index].offset      = offset;
+        toc[index].size        = sources[i].size;
+        toc[index].stored_size = stored_size;
+        toc[index].type        = sources[i].type;
+        toc[index].flags       = compressed[num_entries] ? PACK_ENTRY_COMPRESSED : 0;
+        offset += stored_size;
+        total_size += sources[i].size;
+        ordered[num_entries++] = sources + i;
+    }
+    header.num_entries = num_entries;
+    header.file_size   = offset;
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("Can not open %s for writing\n", path);
+        free_compressed_entries(compressed, num_entries);
+        end_temporary_memory(temp);
+        return false;
+    }
+
+    //entries go out in the order they were laid out above
+    uint64_t written = 0;
+    bool ok = fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+    written += sizeof(header);
+    ok = ok && write_pack_padding(file, &written, header.toc_offset);
+    ok = ok && fwrite(toc, sizeof(pack_entry), toc_size, file) == toc_size;
+    written += toc_size * sizeof(pack_entry);
+    for (uint32_t i = 0; ok && i < num_entries; ++i)
+    {
+        const void* data = compressed[i] ? compressed[i] : ordered[i]->data;
+        uint64_t size = stored_sizes[i];
+        ok = write_pack_padding(file, &written, align_pack_offset(written));
+        ok = ok && fwrite(data, 1, size, file) == size;
+        written += size;
+    }
+    fclose(file);
+    free_compressed_entries(compressed, num_entries);
+    end_temporary_memory(temp);
+
+    if (!ok || written != header.file_size)
+    {
+        printf("Failed to write %s\n", path);
+        remove(path);
+        return false;
+    }
+    printf("Packed %u assets into %s: %llu bytes, %llu uncompressed\n", num_entries, path,
+           (unsigned long long)header.file_size, (unsigned long long)total_size);
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdint.h>
+
+#include "hash.h"
+#include "memory.h"
+
+/*
+    Single file holding all assets, mapped read only at startup. The mapping is shared, several
+    processes running off the same pack share its pages in the page cache.
+
+    Entries that compress well (animation keys, vertices) are stored as independently compressed
+    blocks of PACK_BLOCK_SIZE, see compress.h: the block table, uint32_t per block with where its
+    stored bytes end counted from the end of the table, then the blocks. A block whose stored size is
+    its full size is kept as it is. pack_load decompresses the blocks on the job threads straight into
+    the caller's memory, the other entries are used in place from the mapping and never copied.
+
+    The table of contents is an open addressing table keyed by hash64 of the asset's source path
+    (the path the game asks for, e.g. "Assets/Meshes/Paladin/Sword_and_shield_idle.dae").
+*/
+#define PACK_MAGIC        0x4B415046 //'FPAK'
+#define PACK_VERSION      3
+#define PACK_ALIGNMENT    64
+#define PACK_DEFAULT_PATH "Assets/game.pak"
+#define PACK_BLOCK_SIZE   Kilobytes(256)
+//an entry is only stored compressed if that saves at least 1/PACK_MIN_SAVING of it
+#define PACK_MIN_SAVING   8
+//loads decompressing at the same time with help from the job threads, more go on alone
+#define MAX_PACK_DECOMPRESSIONS 16
+
+enum pack_entry_flags
+{
+    PACK_ENTRY_COMPRESSED = 1 << 0,
+};
+
+enum pack_entry_type
+{
+    PACK_ENTRY_RAW,     //file bytes as they are (sounds, fonts)
+    PACK_ENTRY_BAKED,   //a baked model or animation, see baked_asset.h
+    PACK_ENTRY_TEXTURE, //a mip texture, see mip_texture.h
+    NUM_PACK_ENTRY_TYPES
+};
+
+struct pack_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_entries;
+    uint32_t toc_size;   //power of two, a hash of 0 marks an empty slot
+    uint64_t toc_offset; //pack_entry[toc_size]
+    uint64_t file_size;
+};
+
+struct pack_entry
+{
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t size;        //once loaded
+    uint64_t stored_size; //in the pack, block table included
+    uint32_t type;
+    uint32_t flags;
+};
+
+//what the asset baker feeds to write_pack
+struct pack_source
+{
+    const char*     path;
+    const void*     data;
+    uint64_t        size;
+    pack_entry_type type;
+};
+
+bool        pack_open(const char* path);
+void        pack_close(void);
+//false if there is no pack or the asset isn't in it, or it is stored as another type
+bool        pack_contains(const char* asset_path, pack_entry_type type);
+/*
+    NULL like pack_contains, or if it doesn't decompress. Stored entries come from the mapping,
+    compressed ones are decompressed into the arena, PACK_ALIGNMENT aligned, or malloced if it is NULL.
+*/
+const void* pack_load(const char* asset_path, pack_entry_type type, memory_arena* arena, uint64_t* out_size);
+const void* pack_load_by_hash(uint64_t hash, pack_entry_type type, memory_arena* arena, uint64_t* out_size);
+//for pack_load with a NULL arena, does nothing for bytes in the mapping
+void        pack_free(const void* data);
+//compresses what pays off, stores the rest as it is
+bool        write_pack(const char* path, pack_source* sources, uint32_t num_sources);
+
+#endif
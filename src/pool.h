@@ -0,0 +1,96 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+#include <cassert>
+
+#include "memory.h"
+
+#define POOL_INVALID_INDEX 0xFFFFFFFF
+
+/*
+    Fixed capacity pool of T carved from an arena. Slots never move, so pointers handed out by
+    pool_alloc stay valid until pool_free. Freed slots go on a free list and are reused first.
+    Live slots are also kept packed in m_dense so systems can iterate them without holes.
+*/
+template<typename T>
+struct pool
+{
+    T*        m_slots;
+    uint32_t* m_free_list;   //stack of free slot indices
+    uint32_t* m_dense;       //slot indices of live items, packed
+    uint32_t* m_dense_index; //slot index -> position in m_dense
+    uint32_t  m_capacity;
+    uint32_t  m_num_free;
+    uint32_t  m_count;
+};
+
+template<typename T>
+void pool_init(pool<T>* p_pool, memory_arena* arena, uint32_t capacity)
+{
+    p_pool->m_slots       = push_array<T>(arena, capacity);
+    p_pool->m_free_list   = push_array<uint32_t>(arena, capacity);
+    p_pool->m_dense       = push_array<uint32_t>(arena, capacity);
+    p_pool->m_dense_index = push_array<uint32_t>(arena, capacity);
+    p_pool->m_capacity    = capacity;
+    p_pool->m_num_free    = capacity;
+    p_pool->m_count       = 0;
+
+    //hand out the low slots first
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        p_pool->m_free_list[i]   = capacity - 1 - i;
+        p_pool->m_dense_index[i] = POOL_INVALID_INDEX;
+    }
+}
+
+//returns a zeroed item, or NULL if the pool is full
+template<typename T>
+T* pool_alloc(pool<T>* p_pool)
+{
+    if (p_pool->m_num_free == 0)
+    {
+        return NULL;
+    }
+
+    uint32_t slot = p_pool->m_free_list[--p_pool->m_num_free];
+    p_pool->m_dense_index[slot] = p_pool->m_count;
+    p_pool->m_dense[p_pool->m_count++] = slot;
+
+    T* result = p_pool->m_slots + slot;
+    memset(result, 0, sizeof(T));
+    return result;
+}
+
+template<typename T>
+uint32_t pool_index_of(pool<T>* p_pool, T* item)
+{
+    assert(item >= p_pool->m_slots && item < p_pool->m_slots + p_pool->m_capacity);
+    return (uint32_t)(item - p_pool->m_slots);
+}
+
+template<typename T>
+void pool_free(pool<T>* p_pool, T* item)
+{
+    uint32_t slot = pool_index_of(p_pool, item);
+    uint32_t dense_index = p_pool->m_dense_index[slot];
+    assert(dense_index != POOL_INVALID_INDEX);
+
+    //swap the last live slot into the hole
+    uint32_t last_slot = p_pool->m_dense[--p_pool->m_count];
+    p_pool->m_dense[dense_index] = last_slot;
+    p_pool->m_dense_index[last_slot] = dense_index;
+    p_pool->m_dense_index[slot] = POOL_INVALID_INDEX;
+
+    p_pool->m_free_list[p_pool->m_num_free++] = slot;
+}
+
+//i-th live item, 0 <= i < m_count
+template<typename T>
+T* pool_get(pool<T>* p_pool, uint32_t dense_index)
+{
+    assert(dense_index < p_pool->m_count);
+    return p_pool->m_slots + p_pool->m_dense[dense_index];
+}
+
+#endif
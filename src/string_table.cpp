@@ -0,0 +1,131 @@
+#include "string_table.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <atomic>
+#include <SDL_mutex.h>
+
+#include "hash.h"
+
+struct interned_string
+{
+    uint64_t hash;
+    uint32_t length;
+    char     chars[1]; //length bytes and a terminator
+};
+
+static const interned_string no_string = {};
+
+static memory_arena*           string_arena;
+//index is the id, written once and never moved so readers need no lock
+static const interned_string*  interned_strings[MAX_INTERNED_STRINGS + 1];
+//only grows, readers load it for the bounds check alone
+static std::atomic<uint32_t>   num_interned_strings;
+//ids by hash, open addressing kept at most half full, 0 is an empty slot
+static uint32_t                string_slots[MAX_INTERNED_STRINGS * 2];
+static SDL_mutex*              string_mutex;
+
+bool string_table_init(void)
+{
+    string_arena = create_sub_arena("strings", STRING_MEMORY_BUDGET);
+    string_mutex = SDL_CreateMutex();
+    interned_strings[NO_STRING] = &no_string;
+    num_interned_strings.store(0, std::memory_order_relaxed);
+    memset(string_slots, 0, sizeof(string_slots));
+    return string_arena != NULL && string_mutex != NULL;
+}
+
+static void lock_strings(void)
+{
+    SDL_LockMutex(string_mutex);
+}
+
+static void unlock_strings(void)
+{
+    SDL_UnlockMutex(string_mutex);
+}
+
+//the slot holding it, or the empty slot it would go in
+static uint32_t find_string_slot(const char* str, uint32_t length, uint64_t hash)
+{
+    uint32_t mask = (uint32_t)(sizeof(string_slots) / sizeof(string_slots[0])) - 1;
+    uint32_t index = (uint32_t)hash & mask;
+    for (; string_slots[index] != NO_STRING; index = (index + 1) & mask)
+    {
+        const interned_string* interned = interned_strings[string_slots[index]];
+        if (interned->hash == hash && interned->length == length && memcmp(interned->chars, str, length) == 0)
+        {
+            break;
+        }
+    }
+    return index;
+}
+
+string_id intern_string(const char* str, uint32_t length)
+{
+    uint64_t hash = hash64(str, length);
+    lock_strings();
+    uint32_t slot = find_string_slot(str, length, hash);
+    string_id result = string_slots[slot];
+    uint32_t num_strings = num_interned_strings.load(std::memory_order_relaxed);
+    if (result == NO_STRING && num_strings < MAX_INTERNED_STRINGS)
+    {
+        interned_string* interned = (interned_string*)push_size(string_arena, sizeof(interned_string) + length, alignof(interned_string));
+        if (interned)
+        {
+            interned->hash   = hash;
+            interned->length = length;
+            memcpy(interned->chars, str, length);
+            interned->chars[length] = '\0';
+            result = num_strings + 1;
+            interned_strings[result] = interned;
+            string_slots[slot] = result;
+            num_interned_strings.store(result, std::memory_order_release);
+        }
+    }
+    unlock_strings();
+
+    if (result == NO_STRING)
+    {
+        printf("String table is full, can not intern %.*s\n", (int)length, str);
+    }
+    return result;
+}
+
+string_id intern_string(const char* str)
+{
+    return intern_string(str, (uint32_t)strlen(str));
+}
+
+string_id find_string(const char* str, uint32_t length)
+{
+    uint64_t hash = hash64(str, length);
+    lock_strings();
+    string_id result = string_slots[find_string_slot(str, length, hash)];
+    unlock_strings();
+    return result;
+}
+
+string_id find_string(const char* str)
+{
+    return find_string(str, (uint32_t)strlen(str));
+}
+
+const char* get_string(string_id id)
+{
+    assert(id <= num_interned_strings.load(std::memory_order_relaxed));
+    return interned_strings[id]->chars;
+}
+
+uint32_t get_string_length(string_id id)
+{
+    assert(id <= num_interned_strings.load(std::memory_order_relaxed));
+    return interned_strings[id]->length;
+}
+
+uint64_t get_string_hash(string_id id)
+{
+    assert(id <= num_interned_strings.load(std::memory_order_relaxed));
+    return interned_strings[id]->hash;
+}
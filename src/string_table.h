@@ -0,0 +1,33 @@
+#ifndef STRING_TABLE_H
+#define STRING_TABLE_H
+
+#include <stdint.h>
+
+#include "memory.h"
+
+/*
+    Interned strings for names that are compared a lot and never change: texture paths and types,
+    joint and animation channel names. Every distinct string is stored once, with its hash64, and is
+    known by a string_id from then on, so two names are the same exactly when their ids are. Strings
+    stay until exit, the table only ever grows. Interning and lookups are thread safe, get_string and
+    get_string_hash don't lock at all.
+*/
+#define MAX_INTERNED_STRINGS  (1 << 16)
+#define STRING_MEMORY_BUDGET  Megabytes(4)
+#define NO_STRING             0
+
+typedef uint32_t string_id;
+
+bool        string_table_init(void);
+//NO_STRING if the table is full
+string_id   intern_string(const char* str);
+string_id   intern_string(const char* str, uint32_t length);
+//NO_STRING if it was never interned, doesn't add it
+string_id   find_string(const char* str);
+string_id   find_string(const char* str, uint32_t length);
+//"" for NO_STRING
+const char* get_string(string_id id);
+uint32_t    get_string_length(string_id id);
+uint64_t    get_string_hash(string_id id);
+
+#endif
@@ -14,7 +14,7 @@ void texture_component_init(texture_rendering_info* p_info)
     screen_width = p_info->screen_width;
     screen_height = p_info->screen_height;
     num_texture_components = 0;
-    textures = (sdl_texture*)push_size(MAX_NUM_TEXTURE_COMPONENTS * sizeof(sdl_texture));
+    textures = push_array<sdl_texture>(MAX_NUM_TEXTURE_COMPONENTS);
 }
 
 void destroy_texture_component(entity* p_entity)
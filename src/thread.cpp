@@ -1,24 +1,290 @@
 #include <stdio.h>
+#include <atomic>
+#include <thread>
 #include <SDL_thread.h>
 #include "thread.h"
+#include "memory.h"
+#include "common.h"
+
+#ifdef JOB_SYSTEM_USE_FIBERS
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <ucontext.h>
+#include <sys/mman.h>
+#endif
+#endif
 
 SDL_Thread* threads[NUM_THREADS];
-SDL_mutex* queue_mutex;
-SDL_cond* queue_cond;
 
-thread_job job_queue[256];
-uint32_t num_jobs = 0;
+/*
+    Jobs submitted from outside the workers (main thread, I/O thread) are injected through a bounded
+    multi producer multi consumer ring (Dmitry Vyukov's). Every cell carries a sequence
+    number that says whose turn it is: pos when it is free for the push that claims pos, pos + 1 once
+    that job is in it, pos + JOB_QUEUE_SIZE again after the pop. Pushes and pops only contend on
+    their own counter with one compare and swap, nothing is ever shifted or locked.
+*/
+struct job_cell
+{
+    std::atomic<uint32_t> sequence;
+    thread_job            job;
+};
+
+struct job_ring
+{
+    job_cell                                       cells[JOB_QUEUE_SIZE];
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> enqueue_pos;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> dequeue_pos;
+};
+
+static job_ring job_queue;
+/*
+    Counted jobs from outside the workers have a ring of their own. A thread that isn't a worker
+    only helps with these while it waits, it can't end up running a long asset import in the
+    middle of a frame just because that was next in job_queue.
+*/
+static job_ring counted_job_queue;
+
+static void init_job_queue(job_ring* queue)
+{
+    for (uint32_t i = 0; i < JOB_QUEUE_SIZE; ++i)
+    {
+        queue->cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    queue->enqueue_pos.store(0, std::memory_order_relaxed);
+    queue->dequeue_pos.store(0, std::memory_order_relaxed);
+}
+
+//false if it is full
+static bool push_job(job_ring* queue, thread_job job)
+{
+    uint32_t pos = queue->enqueue_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        job_cell* cell = queue->cells + (pos & (JOB_QUEUE_SIZE - 1));
+        uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+        int32_t  diff = (int32_t)(sequence - pos);
+        if (diff == 0)
+        {
+            if (queue->enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell->job = job;
+                cell->sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            //the pop a whole lap behind hasn't happened yet
+            return false;
+        }
+        else
+        {
+            pos = queue->enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+//false if it is empty, or the oldest job is claimed but not written yet
+static bool pop_job(job_ring* queue, thread_job* out_job)
+{
+    uint32_t pos = queue->dequeue_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        job_cell* cell = queue->cells + (pos & (JOB_QUEUE_SIZE - 1));
+        uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+        int32_t  diff = (int32_t)(sequence - (pos + 1));
+        if (diff == 0)
+        {
+            if (queue->dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                *out_job = cell->job;
+                cell->sequence.store(pos + JOB_QUEUE_SIZE, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = queue->dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/*
+    Every worker owns a Chase-Lev deque (the C11 version by Le, Pop, Cohen and Zappa Nardelli) for
+    the jobs it submits itself. The owner pushes and pops at the bottom, newest first while its data
+    is still in cache, and only synchronizes with thieves over the last job. Idle workers steal the
+    oldest job from the top. It doesn't grow, a push to a full deque goes to the ring instead.
+    The cells are relaxed atomics since a thief may read a cell the owner is writing, it then loses
+    the race on top and drops what it read.
+*/
+struct deque_cell
+{
+    std::atomic<void(*)(void*)> job_function;
+    std::atomic<void*>          arg;
+    std::atomic<job_counter*>   counter;
+};
+
+struct job_deque
+{
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> top;
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> bottom;
+    deque_cell                                    cells[WORKER_DEQUE_SIZE];
+};
+
+//an idle worker sleeps on its semaphore, whoever flips sleeping back to false posts it
+struct worker_sleep
+{
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> sleeping;
+    SDL_sem*                                    semaphore;
+};
+
+static job_deque         worker_deques[NUM_THREADS];
+static worker_sleep      worker_sleeps[NUM_THREADS];
+static std::atomic<bool> job_system_running;
+//index into worker_deques, -1 on threads that aren't workers
+static thread_local int32_t worker_index = -1;
+static thread_local uint32_t steal_seed;
+
+static inline void write_deque_cell(job_deque* deque, int64_t index, thread_job job)
+{
+    deque_cell* cell = deque->cells + (index & (WORKER_DEQUE_SIZE - 1));
+    cell->job_function.store(job.job_function, std::memory_order_relaxed);
+    cell->arg.store(job.arg, std::memory_order_relaxed);
+    cell->counter.store(job.counter, std::memory_order_relaxed);
+}
+
+static inline thread_job read_deque_cell(job_deque* deque, int64_t index)
+{
+    deque_cell* cell = deque->cells + (index & (WORKER_DEQUE_SIZE - 1));
+    thread_job result = { cell->job_function.load(std::memory_order_relaxed), cell->arg.load(std::memory_order_relaxed),
+                          cell->counter.load(std::memory_order_relaxed) };
+    return result;
+}
+
+//owner only, false if it is full
+static bool push_local_job(job_deque* deque, thread_job job)
+{
+    int64_t bottom = deque->bottom.load(std::memory_order_relaxed);
+    int64_t top    = deque->top.load(std::memory_order_acquire);
+    if (bottom - top >= WORKER_DEQUE_SIZE)
+    {
+        return false;
+    }
+    write_deque_cell(deque, bottom, job);
+    deque->bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+//owner only, newest first
+static bool pop_local_job(job_deque* deque, thread_job* out_job)
+{
+    int64_t bottom = deque->bottom.load(std::memory_order_relaxed) - 1;
+    deque->bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = deque->top.load(std::memory_order_relaxed);
+    if (top > bottom)
+    {
+        deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    *out_job = read_deque_cell(deque, bottom);
+    if (top == bottom)
+    {
+        //the last one, a thief may be after it too
+        bool won = deque->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+//any thread, oldest first. False if it is empty or another thread got there first
+static bool steal_job(job_deque* deque, thread_job* out_job)
+{
+    int64_t top = deque->top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = deque->bottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+    {
+        return false;
+    }
+    thread_job job = read_deque_cell(deque, top);
+    if (!deque->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return false;
+    }
+    *out_job = job;
+    return true;
+}
+
+static uint32_t random_victim(void)
+{
+    //xorshift, only has to spread the thieves out
+    steal_seed ^= steal_seed << 13;
+    steal_seed ^= steal_seed >> 17;
+    steal_seed ^= steal_seed << 5;
+    return steal_seed % NUM_THREADS;
+}
+
+//own deque, then what was injected from outside, then the other workers from a random one on
+static bool find_job(thread_job* out_job)
+{
+    if (worker_index >= 0 && pop_local_job(worker_deques + worker_index, out_job))
+    {
+        return true;
+    }
+    if (pop_job(&counted_job_queue, out_job) || pop_job(&job_queue, out_job))
+    {
+        return true;
+    }
+    uint32_t first = random_victim();
+    for (uint32_t i = 0; i < NUM_THREADS; ++i)
+    {
+        uint32_t victim = (first + i) % NUM_THREADS;
+        if ((int32_t)victim != worker_index && steal_job(worker_deques + victim, out_job))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//a submit wakes at most one sleeper
+static void wake_worker(void)
+{
+    //the job has to be visible before the sleepers are looked at, see start_thread
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (uint32_t i = 0; i < NUM_THREADS; ++i)
+    {
+        bool sleeping = true;
+        if (worker_sleeps[i].sleeping.load() && worker_sleeps[i].sleeping.compare_exchange_strong(sleeping, false))
+        {
+            SDL_SemPost(worker_sleeps[i].semaphore);
+            return;
+        }
+    }
+}
 
 void execute_job(thread_job* p_job)
 {
     p_job->job_function(p_job->arg);
+    if (p_job->counter)
+    {
+        //release, whoever sees it drop sees everything the job wrote
+        p_job->counter->value.fetch_sub(1, std::memory_order_release);
+    }
 }
 
 void func1(void* arg)
 {
-    SDL_LockMutex(queue_mutex);
     printf("Func1 is printing...\n");
-    SDL_UnlockMutex(queue_mutex);
 }
 
 void func2(void* arg)
@@ -27,51 +293,427 @@ void func2(void* arg)
     printf("Func2 is printing %s\n", str);
 }
 
+/*
+    Workers keep what they submit in their own deque, everybody else injects through the ring. When
+    both are full the job runs right here instead of being dropped, which is also what holds back a
+    thread that submits faster than the workers can keep up.
+*/
 void submit_job(thread_job job)
 {
-    SDL_LockMutex(queue_mutex);
-    job_queue[num_jobs] = job;
-    num_jobs++;
-    SDL_UnlockMutex(queue_mutex);
-    SDL_CondSignal(queue_cond);
+    //before job_system_init there is nobody to hand it to
+    job_ring* queue = job.counter ? &counted_job_queue : &job_queue;
+    bool queued = job_system_running &&
+                  ((worker_index >= 0 && push_local_job(worker_deques + worker_index, job)) || push_job(queue, job));
+    if (!queued)
+    {
+        execute_job(&job);
+        return;
+    }
+    wake_worker();
+}
+
+void submit_job_blocking(thread_job job)
+{
+    job_ring* queue = job.counter ? &counted_job_queue : &job_queue;
+    if (!job_system_running)
+    {
+        execute_job(&job);
+        return;
+    }
+    while (!push_job(queue, job))
+    {
+        //the workers are behind, let them catch up
+        wake_worker();
+        std::this_thread::yield();
+    }
+    wake_worker();
+}
+
+void submit_job(thread_job job, job_counter* counter)
+{
+    counter->value.fetch_add(1, std::memory_order_relaxed);
+    job.counter = counter;
+    submit_job(job);
+}
+
+#ifdef JOB_SYSTEM_USE_FIBERS
+/*
+    A worker's own thread only schedules: it takes a free fiber for every job it finds and switches
+    to it, the fiber switches back when the job is done or parks. Fibers never move to another
+    worker, so thread_local state and the worker's arenas stay where a parked job left them.
+    Everything here is only touched by the worker that owns it.
+*/
+struct job_fiber
+{
+#ifdef _WIN32
+    void*        handle;
+#else
+    ucontext_t   context;
+#endif
+    thread_job   job;
+    job_counter* wait_counter; //set while it is parked
+    uint32_t     wait_value;
+};
+
+struct worker_fibers
+{
+#ifdef _WIN32
+    void*      scheduler;
+#else
+    ucontext_t scheduler;
+#endif
+    job_fiber  fibers[JOB_FIBERS_PER_WORKER];
+    job_fiber* free_fibers[JOB_FIBERS_PER_WORKER];
+    uint32_t   num_free;
+    job_fiber* parked_fibers[JOB_FIBERS_PER_WORKER];
+    uint32_t   num_parked;
+};
+
+static worker_fibers worker_fiber_pools[NUM_THREADS];
+//the fiber running on this thread, NULL on the scheduler and on threads that aren't workers
+static thread_local job_fiber* current_fiber;
+
+static void switch_to_scheduler(job_fiber* fiber)
+{
+    worker_fibers* pool = worker_fiber_pools + worker_index;
+#ifdef _WIN32
+    (void)fiber;
+    SwitchToFiber(pool->scheduler);
+#else
+    swapcontext(&fiber->context, &pool->scheduler);
+#endif
+}
+
+//runs jobs for as long as the worker hands them out, it never returns
+static void fiber_main(void)
+{
+    for (;;)
+    {
+        job_fiber* fiber = current_fiber;
+        execute_job(&fiber->job);
+        switch_to_scheduler(fiber);
+    }
+}
+
+#ifdef _WIN32
+static void WINAPI fiber_entry(void* arg)
+{
+    (void)arg;
+    fiber_main();
+}
+#endif
+
+//a worker without fibers runs its jobs on its own stack
+static void init_worker_fibers(worker_fibers* pool)
+{
+    pool->num_free   = 0;
+    pool->num_parked = 0;
+#ifdef _WIN32
+    pool->scheduler = ConvertThreadToFiber(NULL);
+    if (!pool->scheduler)
+    {
+        printf("Failed to make the worker a fiber\n");
+        return;
+    }
+#endif
+    for (uint32_t i = 0; i < JOB_FIBERS_PER_WORKER; ++i)
+    {
+        job_fiber* fiber = pool->fibers + i;
+#ifdef _WIN32
+        fiber->handle = CreateFiber(JOB_FIBER_STACK_SIZE, &fiber_entry, NULL);
+        if (!fiber->handle)
+        {
+            printf("Failed to create job fiber %u\n", i);
+            return;
+        }
+#else
+        //the lowest page is left inaccessible, an overflowing job faults instead of running into the next stack
+        uint8_t* stack = (uint8_t*)mmap(NULL, JOB_FIBER_STACK_SIZE + ARENA_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (stack == MAP_FAILED || mprotect(stack, ARENA_PAGE_SIZE, PROT_NONE) != 0)
+        {
+            printf("Failed to allocate the stack of job fiber %u\n", i);
+            return;
+        }
+        getcontext(&fiber->context);
+        fiber->context.uc_stack.ss_sp   = stack + ARENA_PAGE_SIZE;
+        fiber->context.uc_stack.ss_size = JOB_FIBER_STACK_SIZE;
+        fiber->context.uc_link          = NULL;
+        makecontext(&fiber->context, &fiber_main, 0);
+#endif
+        fiber->wait_counter = NULL;
+        pool->free_fibers[pool->num_free++] = fiber;
+    }
+}
+
+//comes back when the fiber finished its job or parked
+static void switch_to_fiber(worker_fibers* pool, job_fiber* fiber)
+{
+    current_fiber = fiber;
+#ifdef _WIN32
+    SwitchToFiber(fiber->handle);
+#else
+    swapcontext(&pool->scheduler, &fiber->context);
+#endif
+    current_fiber = NULL;
+
+    if (fiber->wait_counter)
+    {
+        pool->parked_fibers[pool->num_parked++] = fiber;
+    }
+    else
+    {
+        pool->free_fibers[pool->num_free++] = fiber;
+    }
+}
+
+static void run_job(thread_job* p_job)
+{
+    worker_fibers* pool = worker_fiber_pools + worker_index;
+    if (pool->num_free == 0)
+    {
+        //only when the pool couldn't be made, a fiber doesn't park without leaving one free
+        execute_job(p_job);
+        return;
+    }
+    job_fiber* fiber = pool->free_fibers[--pool->num_free];
+    fiber->job = *p_job;
+    switch_to_fiber(pool, fiber);
+}
+
+//false if none of the parked fibers can go on yet
+static bool resume_parked_fiber(void)
+{
+    worker_fibers* pool = worker_fiber_pools + worker_index;
+    for (uint32_t i = 0; i < pool->num_parked; ++i)
+    {
+        job_fiber* fiber = pool->parked_fibers[i];
+        if (fiber->wait_counter->value.load(std::memory_order_acquire) <= fiber->wait_value)
+        {
+            pool->parked_fibers[i] = pool->parked_fibers[--pool->num_parked];
+            fiber->wait_counter = NULL;
+            switch_to_fiber(pool, fiber);
+            return true;
+        }
+    }
+    return false;
+}
+
+//false if the wait has to happen here, on a thread without fibers or with all of them taken
+static bool park_fiber(job_counter* counter, uint32_t value)
+{
+    job_fiber* fiber = current_fiber;
+    if (!fiber || worker_fiber_pools[worker_index].num_free == 0)
+    {
+        return false;
+    }
+    fiber->wait_counter = counter;
+    fiber->wait_value   = value;
+    switch_to_scheduler(fiber);
+    return true;
+}
+#else
+static void run_job(thread_job* p_job)
+{
+    execute_job(p_job);
+}
+#endif
+
+void wait_for_counter(job_counter* counter, uint32_t value)
+{
+#ifdef JOB_SYSTEM_USE_FIBERS
+    if (counter->value.load(std::memory_order_acquire) > value && park_fiber(counter, value))
+    {
+        //the worker saw it get there before resuming this fiber on the same thread
+        return;
+    }
+#endif
+    while (counter->value.load(std::memory_order_acquire) > value)
+    {
+        thread_job job;
+        bool found = worker_index >= 0 ? find_job(&job) : pop_job(&counted_job_queue, &job);
+        if (found)
+        {
+            execute_job(&job);
+        }
+        else
+        {
+            //what is left runs on the workers
+            std::this_thread::yield();
+        }
+    }
+}
+
+struct parallel_for_range;
+
+struct parallel_for_task
+{
+    parallel_for_function function;
+    void*                 arg;
+    uint32_t              grain;
+    job_counter           counter;
+    parallel_for_range*   ranges;
+    std::atomic<uint32_t> num_ranges;
+};
+
+struct parallel_for_range
+{
+    parallel_for_task* task;
+    uint32_t           begin;
+    uint32_t           end;
+};
+
+//hands the upper half off while the range is bigger than the grain, then runs what is left
+static void parallel_for_job(void* arg)
+{
+    parallel_for_range* range = (parallel_for_range*)arg;
+    parallel_for_task*  task  = range->task;
+    uint32_t begin = range->begin;
+    uint32_t end   = range->end;
+    while (end - begin > task->grain)
+    {
+        uint32_t middle = begin + (end - begin) / 2;
+        parallel_for_range* half = task->ranges + task->num_ranges.fetch_add(1, std::memory_order_relaxed);
+        half->task  = task;
+        half->begin = middle;
+        half->end   = end;
+        thread_job job = { &parallel_for_job, half, NULL };
+        submit_job(job, &task->counter);
+        end = middle;
+    }
+    task->function(begin, end, task->arg);
+}
+
+/*
+    The ranges stay on the caller's stack until everything has run, not in its scratch arena, which
+    other jobs on the same worker push to while a fiber is parked. Every split leaves halves of at
+    least half a grain, so there are never more than 2 * count / grain of them.
+*/
+void parallel_for(uint32_t count, uint32_t grain, parallel_for_function function, void* arg)
+{
+    if (grain == 0)
+    {
+        grain = count / (PARALLEL_FOR_SPLITS * (NUM_THREADS + 1));
+        grain = grain > PARALLEL_FOR_MIN_GRAIN ? grain : PARALLEL_FOR_MIN_GRAIN;
+    }
+    uint32_t min_grain = (count + PARALLEL_FOR_MAX_RANGES / 2 - 2) / (PARALLEL_FOR_MAX_RANGES / 2 - 1);
+    grain = grain > min_grain ? grain : min_grain;
+    if (count <= grain || !job_system_running)
+    {
+        if (count)
+        {
+            function(0, count, arg);
+        }
+        return;
+    }
+
+    parallel_for_range ranges[PARALLEL_FOR_MAX_RANGES];
+    parallel_for_task task;
+    task.function = function;
+    task.arg      = arg;
+    task.grain    = grain;
+    task.counter.value.store(0, std::memory_order_relaxed);
+    task.ranges   = ranges;
+    task.num_ranges.store(1, std::memory_order_relaxed);
+    ranges[0].task  = &task;
+    ranges[0].begin = 0;
+    ranges[0].end   = count;
+
+    //the caller takes the first half all the way down and helps with the rest while it waits
+    parallel_for_job(ranges);
+    wait_for_counter(&task.counter);
 }
 
 int start_thread(void* args)
 {
+    //every worker pushes into its own arena, index 0 belongs to the main thread
+    uint32_t thread_index = (uint32_t)(uintptr_t)args;
+    attach_thread_memory(thread_index);
+    worker_index = (int32_t)thread_index - 1;
+    steal_seed   = 0x9E3779B9u * thread_index;
+#ifdef JOB_SYSTEM_USE_FIBERS
+    init_worker_fibers(worker_fiber_pools + worker_index);
+#endif
+
     for(;;)
     {
+#ifdef JOB_SYSTEM_USE_FIBERS
+        //a parked job goes on before new ones are started, what it waited for is done
+        if (resume_parked_fiber())
+        {
+            continue;
+        }
+#endif
         thread_job job;
-        SDL_LockMutex(queue_mutex);
-        
-        while(num_jobs == 0)
+        bool found = false;
+        for (uint32_t i = 0; i < JOB_SPIN_ROUNDS && !found; ++i)
         {
-            SDL_CondWait(queue_cond, queue_mutex);
+            found = find_job(&job);
+            if (!found)
+            {
+                std::this_thread::yield();
+            }
         }
+        if (found)
+        {
+            run_job(&job);
+            continue;
+        }
+#ifdef JOB_SYSTEM_USE_FIBERS
+        //nothing signals a counter reaching its value, so a worker with parked fibers keeps looking
+        if (worker_fiber_pools[worker_index].num_parked)
+        {
+            continue;
+        }
+#endif
 
-        job = job_queue[0];
-
-        for(uint32_t i = 0; i < num_jobs - 1; ++i)
+        //announce the sleep first and look once more, a submit either sees the sleeper or is seen here
+        worker_sleep* sleep = worker_sleeps + worker_index;
+        sleep->sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (find_job(&job))
         {
-            job_queue[i] = job_queue[i+1];
+            //take the announcement back, unless a submit got to it first and posts
+            bool sleeping = true;
+            if (!sleep->sleeping.compare_exchange_strong(sleeping, false))
+            {
+                SDL_SemWait(sleep->semaphore);
+            }
+            run_job(&job);
+            continue;
         }
-        num_jobs--;
-        SDL_UnlockMutex(queue_mutex);
-        execute_job(&job);
+        SDL_SemWait(sleep->semaphore);
     }
     return 0;
 }
 
 void job_system_init(void)
 {
-    queue_mutex = SDL_CreateMutex();
-    queue_cond  = SDL_CreateCond();
+    init_job_queue(&job_queue);
+    init_job_queue(&counted_job_queue);
+    for(uint32_t i = 0; i < NUM_THREADS; ++i)
+    {
+        worker_sleeps[i].semaphore = SDL_CreateSemaphore(0);
+    }
+
+    if(!thread_memory_init(NUM_THREADS + 1))
+    {
+        printf("Failed to create thread arenas, jobs run where they are submitted\n");
+        return;
+    }
+    attach_thread_memory(0);
 
+    uint32_t num_workers = 0;
     for(uint32_t i = 0; i < NUM_THREADS; ++i)
     {
-        threads[i] = SDL_CreateThread(&start_thread, "Thread", NULL);
+        threads[i] = SDL_CreateThread(&start_thread, "Thread", (void*)(uintptr_t)(i + 1));
         if(threads[i] == NULL)
         {
             perror("Failed to create the thread\n");
+            continue;
         }
+        num_workers++;
     }
-}
\ No newline at end of file
+    //only once somebody drains the queues, until then submit_job runs jobs right away
+    job_system_running = num_workers > 0;
+}
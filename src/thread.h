@@ -1,15 +1,76 @@
+#ifndef THREAD_H
+#define THREAD_H
 
+#include <stdint.h>
+#include <atomic>
+
+#ifndef NUM_THREADS
 #define NUM_THREADS 4
+#endif
+/*
+    Work stealing: every worker has a deque of its own for the jobs it submits, jobs from other
+    threads are injected through shared rings, one for counted jobs and one for the rest. Idle
+    workers steal from the others before they sleep. Both sizes are powers of two, a job submitted
+    while its queue is full runs right away on the submitting thread.
+*/
+#define JOB_QUEUE_SIZE    1024
+#define WORKER_DEQUE_SIZE 256
+//times an idle worker looks for work before it goes to sleep
+#define JOB_SPIN_ROUNDS   64
+
+/*
+    parallel_for splits a range in halves for as long as they are bigger than the grain, so idle
+    workers steal big halves first and split them further themselves. With grain 0 it is picked from
+    the count, about PARALLEL_FOR_SPLITS ranges per thread but never fewer than PARALLEL_FOR_MIN_GRAIN
+    items, a range that small runs right away on the calling thread. The ranges are kept on the
+    caller's stack, the grain is raised for counts that would need more than PARALLEL_FOR_MAX_RANGES.
+*/
+#define PARALLEL_FOR_SPLITS     4
+#define PARALLEL_FOR_MIN_GRAIN  32
+#define PARALLEL_FOR_MAX_RANGES 256
+
+/*
+    JOB_SYSTEM_USE_FIBERS: workers run every job on a fiber from a pool of their own, made with its
+    stack when the worker starts (ucontext on Linux, CreateFiber on Windows). A job that waits on a
+    counter parks its fiber and the worker goes on with other jobs on another one, the parked fiber
+    is resumed on the same worker once the counter got there. With every fiber of a worker parked
+    a wait helps with other jobs right where it is, as it does without fibers.
+*/
+#define JOB_FIBERS_PER_WORKER 16
+#define JOB_FIBER_STACK_SIZE  Kilobytes(256)
+
+//jobs submitted with it that haven't finished yet
+struct job_counter
+{
+    std::atomic<uint32_t> value;
+};
 
 typedef struct 
 {
     void(*job_function)(void*);
     void* arg;
+    job_counter* counter; //counted down once the job has run, may be NULL
 }thread_job;
 
 void execute_job(thread_job* p_job);
 void func1(void* arg);
 void func2(void* arg);
 void submit_job(thread_job job);
+//counts the job on the counter before it is handed out
+void submit_job(thread_job job, job_counter* counter);
+//waits for room in the queue instead of running the job on the calling thread, for the I/O threads
+void submit_job_blocking(thread_job job);
+/*
+    Returns once the counter is down to value. The waiting thread runs queued jobs meanwhile instead
+    of sleeping. A worker can pick up any job, other threads (the main thread) only counted jobs that
+    were submitted from outside the workers, never one that streams assets in. A job on a fiber parks it instead
+    and comes back on the same worker.
+*/
+void wait_for_counter(job_counter* counter, uint32_t value = 0);
+//calls function on subranges of [0, count) that cover it once, returns when all of them have run
+typedef void(*parallel_for_function)(uint32_t begin, uint32_t end, void* arg);
+void parallel_for(uint32_t count, uint32_t grain, parallel_for_function function, void* arg);
 int  start_thread(void* args);
-void job_system_init(void);
\ No newline at end of file
+void job_system_init(void);
+
+#endif
@@ -1,6 +1,7 @@
 #include "world.h"
 
-static world* p_world;
+static world*        p_world;
+static memory_arena* world_arena;
 
 world_chunk* map_world_position_to_world_chunk(glm::vec2& world_position)
 {
@@ -42,7 +43,7 @@ world_chunk* map_world_position_to_world_chunk(glm::vec2& world_position)
         result->m_is_initialized = true;
         result->m_chunk_x = chunk_x;
         result->m_chunk_y = chunk_y;
-        result->m_entities = (entity**)push_size(MAX_NUM_ENTITY_PER_CHUNK*sizeof(entity*));
+        result->m_entities = push_array<entity*>(world_arena, MAX_NUM_ENTITY_PER_CHUNK);
 
         p_world->num_world_chunks++;
         printf("Initializing chunk %d\n", chunk_hash);
@@ -73,7 +74,6 @@ entity* map_entity_to_world_chunk(entity* p_entity)
 
     if (!result)
     {
-        p_chunk->m_num_entities--;
         return result;
     }
     //store the pointer in chunk
@@ -82,10 +82,36 @@ entity* map_entity_to_world_chunk(entity* p_entity)
     return result;
 }
 
+/*
+    entities don't remember their chunk and may have moved since they were mapped,
+    so look through every live chunk. Only happens when an entity is destroyed.
+*/
+void remove_entity_from_world(entity* p_entity)
+{
+    for (uint32_t i = 0; i < MAX_NUM_WORLD_CHUNKS; ++i)
+    {
+        world_chunk* p_chunk = p_world->world_chunks + i;
+        if (!p_chunk->m_is_initialized)
+        {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < p_chunk->m_num_entities; ++j)
+        {
+            if (p_chunk->m_entities[j] == p_entity)
+            {
+                p_chunk->m_entities[j] = p_chunk->m_entities[--p_chunk->m_num_entities];
+                return;
+            }
+        }
+    }
+}
+
 void world_init(void)
 {
-    p_world = (world*)push_size(sizeof(world));
-    p_world->world_chunks = (world_chunk*)push_size(MAX_NUM_WORLD_CHUNKS * sizeof(world_chunk));
+    world_arena = create_sub_arena("world", WORLD_MEMORY_BUDGET);
+    p_world = push_struct<world>(world_arena);
+    p_world->world_chunks = push_array<world_chunk>(world_arena, MAX_NUM_WORLD_CHUNKS);
     memset(p_world->world_chunks, 0, MAX_NUM_WORLD_CHUNKS * sizeof(world_chunk));
     p_world->num_world_chunks = 0;
 }
@@ -9,6 +9,7 @@
 #define MAX_NUM_WORLD_CHUNKS        128
 #define WORLD_CHUNK_SIZE            40.0f
 #define MAX_NUM_ENTITY_PER_CHUNK    1024
+#define WORLD_MEMORY_BUDGET         Megabytes(4)
 
 struct world_chunk
 {
@@ -33,6 +34,7 @@ struct sim_region
 
 void         world_init(void);
 entity*      map_entity_to_world_chunk(entity* p_entity);
+void         remove_entity_from_world(entity* p_entity);
 world_chunk* map_world_position_to_world_chunk(glm::vec2& world_position);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,324 @@
+/*
+    Offline asset baker. Imports a .dae (or anything else Assimp reads) with the same post processing
+    the game uses and writes the binary format from src/baked_asset.h. load_model_from_file and
+    load_animation_from_file pick the baked file up instead of the source when it sits next to it.
+    Images are baked with their whole mip chain (src/mip_texture.h), the same way.
+
+    asset_baker model <model.dae> [out.fasset]                    skinned model, skeleton, its animation
+    asset_baker static <model.dae> [out.fasset]                   meshes only
+    asset_baker animation <model.dae> <animation.dae> [out.fasset] animation, bound by joint name on load
+    asset_baker texture <image.png> [out.ftex]                     image and its mip chain
+    asset_baker pack <out.pak> <asset path>...                    pack file, see src/pack.h
+
+    Pack entries are keyed by the path the game loads them with. Models and animations go in as their
+    baked file (bake them first), images are stored as mip textures, anything else as it is.
+    Textures referenced by baked models are added on their own. Every entry that compresses well
+    enough is stored as compressed blocks (src/compress.h), the rest as it is.
+
+    Build it from the game sources minus game.cpp, it needs Assimp and SDL but no window or GL context.
+
+    g++ -O2 -std=c++14 -Isrc -o asset_baker tools/asset_baker/asset_baker.cpp `ls src/*.cpp | grep -v game.cpp`
+        src/glad.c `sdl2-config --cflags --libs` -lSDL2_image -lassimp
+
+    The game prints "Streamed <path> in <ms>" for every load, run it with and without the baked file
+    next to the source to compare the two.
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include "../../src/memory.h"
+#include "../../src/asset.h"
+#include "../../src/mesh.h"
+#include "../../src/entity.h"
+#include "../../src/character.h"
+#include "../../src/baked_asset.h"
+#include "../../src/pack.h"
+#include "../../src/mip_texture.h"
+#include "../../src/string_table.h"
+
+#include <stb/stb_image.h>
+
+#define MAX_PACK_SOURCES 4096
+
+static void print_usage(void)
+{
+    printf("usage: asset_baker model <model.dae> [out.fasset]\n");
+    printf("       asset_baker static <model.dae> [out.fasset]\n");
+    printf("       asset_baker animation <model.dae> <animation.dae> [out.fasset]\n");
+    printf("       asset_baker texture <image.png> [out.ftex]\n");
+    printf("       asset_baker pack <out.pak> <asset path>...\n");
+}
+
+static uint8_t* read_entire_file(const char* path, uint64_t* out_size)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t* result = (uint8_t*)push_size((uint64_t)size + 1, PACK_ALIGNMENT);
+    if (result && fread(result, 1, (size_t)size, file) != (size_t)size)
+    {
+        result = NULL;
+    }
+    fclose(file);
+    *out_size = (uint64_t)size;
+    return result;
+}
+
+static bool is_image_path(const char* path)
+{
+    const char* extensions[] = {".png", ".jpg", ".jpeg", ".tga", ".bmp"};
+    const char* dot = strrchr(path, '.');
+    for (uint32_t i = 0; dot && i < array_count(extensions); ++i)
+    {
+        if (strcmp(dot, extensions[i]) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_in_pack(pack_source* sources, uint32_t num_sources, const char* path)
+{
+    for (uint32_t i = 0; i < num_sources; ++i)
+    {
+        if (strcmp(sources[i].path, path) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//decodes the image and builds its mip chain in game memory
+static uint8_t* bake_texture(const char* path, uint64_t* out_size)
+{
+    int32_t width, height, num_components;
+    uint8_t* texels = stbi_load(path, &width, &height, &num_components, 0);
+    if (!texels)
+    {
+        printf("Can not load image %s\n", path);
+        return NULL;
+    }
+
+    uint8_t* result = build_mip_texture(texels, (uint32_t)width, (uint32_t)height, (uint32_t)num_components,
+                                        get_game_memory_arena(), out_size);
+    stbi_image_free(texels);
+    if (!result)
+    {
+        printf("Can not build the mip chain of %s\n", path);
+    }
+    return result;
+}
+
+static bool add_pack_texture(pack_source* source, const char* path)
+{
+    uint64_t size = 0;
+    uint8_t* data = bake_texture(path, &size);
+    if (!data)
+    {
+        return false;
+    }
+
+    source->path = path;
+    source->data = data;
+    source->size = size;
+    source->type = PACK_ENTRY_TEXTURE;
+    return true;
+}
+
+static int write_baked_texture(const char* image_path, const char* out_path)
+{
+    uint64_t size = 0;
+    uint8_t* data = bake_texture(image_path, &size);
+    if (!data)
+    {
+        return 1;
+    }
+
+    FILE* file = fopen(out_path, "wb");
+    if (!file)
+    {
+        printf("Can not open %s for writing\n", out_path);
+        return 1;
+    }
+    bool ok = fwrite(data, 1, size, file) == size;
+    fclose(file);
+    if (!ok)
+    {
+        printf("Failed to write %s\n", out_path);
+        remove(out_path);
+        return 1;
+    }
+
+    mip_texture_header* header = (mip_texture_header*)data;
+    printf("Baked %s: %ux%u, %u levels, %llu bytes\n", out_path, header->width, header->height,
+           header->num_levels, (unsigned long long)size);
+    return 0;
+}
+
+static int build_pack(const char* out_path, char** paths, uint32_t num_paths)
+{
+    pack_source* sources = push_array<pack_source>(MAX_PACK_SOURCES);
+    uint32_t num_sources = 0;
+
+    for (uint32_t i = 0; i < num_paths && num_sources < MAX_PACK_SOURCES; ++i)
+    {
+        const char* path = paths[i];
+        if (is_in_pack(sources, num_sources, path))
+        {
+            continue;
+        }
+
+        if (is_image_path(path))
+        {
+            if (!add_pack_texture(sources + num_sources, path))
+            {
+                return 1;
+            }
+            num_sources++;
+            continue;
+        }
+
+        //models and animations go in baked
+        char baked_path[MAX_ASSET_PATH_LENGTH];
+        get_baked_asset_path(path, baked_path, sizeof(baked_path));
+        uint64_t size = 0;
+        uint8_t* data = read_entire_file(baked_path, &size);
+        pack_entry_type type = PACK_ENTRY_BAKED;
+        if (!data)
+        {
+            data = read_entire_file(path, &size);
+            type = PACK_ENTRY_RAW;
+        }
+        if (!data)
+        {
+            printf("Can not read %s\n", path);
+            return 1;
+        }
+
+        sources[num_sources].path = path;
+        sources[num_sources].data = data;
+        sources[num_sources].size = size;
+        sources[num_sources].type = type;
+        num_sources++;
+
+        if (type != PACK_ENTRY_BAKED || size < sizeof(baked_asset_header))
+        {
+            continue;
+        }
+
+        //pull in the textures the model uses
+        baked_asset_header* header = (baked_asset_header*)data;
+        baked_mesh* meshes = (baked_mesh*)(data + header->meshes_offset);
+        for (uint32_t m = 0; m < header->num_meshes; ++m)
+        {
+            baked_texture* textures = (baked_texture*)(data + meshes[m].textures_offset);
+            for (uint32_t t = 0; t < meshes[m].num_textures && num_sources < MAX_PACK_SOURCES; ++t)
+            {
+                if (is_in_pack(sources, num_sources, textures[t].path))
+                {
+                    continue;
+                }
+                if (add_pack_texture(sources + num_sources, textures[t].path))
+                {
+                    num_sources++;
+                }
+            }
+        }
+    }
+
+    return write_pack(out_path, sources, num_sources) ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        print_usage();
+        return 1;
+    }
+
+    if (!game_memory_init())
+    {
+        printf("Can not allocate memory, quitting!\n");
+        return 2;
+    }
+    string_table_init();
+    asset_storage_init();
+    mesh_component_init();
+
+    const char* mode = argv[1];
+    char out_path[MAX_ASSET_PATH_LENGTH];
+
+    if (strcmp(mode, "pack") == 0 && argc > 3)
+    {
+        return build_pack(argv[2], argv + 3, (uint32_t)(argc - 3));
+    }
+
+    if (strcmp(mode, "texture") == 0)
+    {
+        if (argc > 3)
+        {
+            snprintf(out_path, sizeof(out_path), "%s", argv[3]);
+        }
+        else
+        {
+            get_baked_path(argv[2], MIP_TEXTURE_EXTENSION, out_path, sizeof(out_path));
+        }
+        return write_baked_texture(argv[2], out_path);
+    }
+
+    character model;
+    memset(&model, 0, sizeof(character));
+    model.m_type = strcmp(mode, "static") == 0 ? ET_STATIC_GEOMETRY : ET_CHARACTER;
+
+    if (strcmp(mode, "model") == 0 || strcmp(mode, "static") == 0)
+    {
+        if (!import_model(&model, argv[2], 1))
+        {
+            return 1;
+        }
+        if (argc > 3)
+        {
+            snprintf(out_path, sizeof(out_path), "%s", argv[3]);
+        }
+        else
+        {
+            get_baked_asset_path(argv[2], out_path, sizeof(out_path));
+        }
+        return write_baked_model(&model, out_path) ? 0 : 1;
+    }
+
+    if (strcmp(mode, "animation") == 0 && argc > 3)
+    {
+        //the model's skeleton is only needed to import the channels, the baked file keys them by joint name
+        if (!import_model(&model, argv[2], 2))
+        {
+            return 1;
+        }
+        uint32_t anim_index = model.m_num_animations;
+        if (!import_animation(&model, argv[3]))
+        {
+            return 1;
+        }
+        if (argc > 4)
+        {
+            snprintf(out_path, sizeof(out_path), "%s", argv[4]);
+        }
+        else
+        {
+            get_baked_asset_path(argv[3], out_path, sizeof(out_path));
+        }
+        return write_baked_animation(&model, anim_index, out_path) ? 0 : 1;
+    }
+
+    print_usage();
+    return 1;
+}
@@ -0,0 +1,89 @@
+/*
+    Asset table benchmark. Adds MAX_NUM_ASSETS paths shaped like the game's, then looks every one of
+    them up again by path (acquire_asset, hash and string compare) and by hash alone
+    (is_asset_loaded), and looks up as many paths that aren't there. Build with
+    -DMAX_NUM_ASSETS=131072 to run it at 100k assets.
+
+    g++ -O2 -std=c++14 -DMAX_NUM_ASSETS=131072 -Isrc tools/bench/asset_table_bench.cpp src/asset.cpp
+        src/memory.cpp src/hash.cpp `sdl2-config --cflags --libs`
+*/
+#include <stdio.h>
+#include <SDL_timer.h>
+
+#include "../../src/memory.h"
+#include "../../src/asset.h"
+
+#define BENCH_NUM_ASSETS (MAX_NUM_ASSETS > 100000 ? 100000 : MAX_NUM_ASSETS)
+
+static char bench_paths[BENCH_NUM_ASSETS][48];
+
+static double get_elapsed_ns(uint64_t start, uint32_t count)
+{
+    uint64_t elapsed = SDL_GetPerformanceCounter() - start;
+    return (double)elapsed * 1e9 / (double)SDL_GetPerformanceFrequency() / (double)count;
+}
+
+int main(void)
+{
+    if (!game_memory_init())
+    {
+        printf("Can not allocate memory, quitting!\n");
+        return 2;
+    }
+    asset_storage_init();
+
+    for (uint32_t i = 0; i < BENCH_NUM_ASSETS; ++i)
+    {
+        snprintf(bench_paths[i], sizeof(bench_paths[i]), "Assets/Meshes/Bench/asset_%06u.dae", i);
+    }
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (uint32_t i = 0; i < BENCH_NUM_ASSETS; ++i)
+    {
+        if (!acquire_asset(bench_paths[i], ASSET_TYPE_MESH))
+        {
+            printf("Could only add %u assets\n", i);
+            return 1;
+        }
+    }
+    double insert_ns = get_elapsed_ns(start, BENCH_NUM_ASSETS);
+
+    start = SDL_GetPerformanceCounter();
+    for (uint32_t i = 0; i < BENCH_NUM_ASSETS; ++i)
+    {
+        release_asset(acquire_asset(bench_paths[i], ASSET_TYPE_MESH));
+    }
+    double path_ns = get_elapsed_ns(start, BENCH_NUM_ASSETS);
+
+    static uint64_t hashes[BENCH_NUM_ASSETS];
+    for (uint32_t i = 0; i < BENCH_NUM_ASSETS; ++i)
+    {
+        hashes[i] = asset_path_hash(bench_paths[i]);
+    }
+    //nothing is loaded, the lookup still has to find the slot to tell
+    start = SDL_GetPerformanceCounter();
+    for (uint32_t i = 0; i < BENCH_NUM_ASSETS; ++i)
+    {
+        is_asset_loaded(hashes[i]);
+    }
+    double hash_ns = get_elapsed_ns(start, BENCH_NUM_ASSETS);
+
+    for (uint32_t i = 0; i < BENCH_NUM_ASSETS; ++i)
+    {
+        bench_paths[i][14] = 'X';
+        hashes[i] = asset_path_hash(bench_paths[i]);
+    }
+    start = SDL_GetPerformanceCounter();
+    for (uint32_t i = 0; i < BENCH_NUM_ASSETS; ++i)
+    {
+        is_asset_loaded(hashes[i]);
+    }
+    double miss_ns = get_elapsed_ns(start, BENCH_NUM_ASSETS);
+
+    printf("%u assets\n", get_num_assets());
+    printf("insert             %8.1f ns\n", insert_ns);
+    printf("lookup by path     %8.1f ns\n", path_ns);
+    printf("lookup by hash     %8.1f ns\n", hash_ns);
+    printf("miss by hash       %8.1f ns\n", miss_ns);
+    return 0;
+}
@@ -0,0 +1,86 @@
+/*
+    Hash benchmark. Hashes the same keys with murmur3_32, hash64 and hash64_batch for a range of key
+    lengths and prints the throughput of each. Asset paths are in the 32-64 byte range.
+
+    g++ -O2 -std=c++14 -Isrc tools/bench/hash_bench.cpp src/hash.cpp `sdl2-config --cflags --libs`
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL_timer.h>
+
+#include "../../src/hash.h"
+
+//hashed per key length and function
+#define BENCH_BYTES    (64ULL << 20)
+#define BENCH_MAX_KEYS 4096
+
+static const uint32_t key_lengths[] = { 8, 16, 32, 64, 128, 256, 1024 };
+
+//the checksums keep the compiler from dropping hashes nobody reads
+static uint64_t checksum;
+
+static double get_gigabytes_per_second(uint64_t start, uint64_t num_bytes)
+{
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    return (double)num_bytes / seconds / 1e9;
+}
+
+int main(void)
+{
+    uint32_t max_length = key_lengths[sizeof(key_lengths) / sizeof(key_lengths[0]) - 1];
+    char* data = (char*)malloc(BENCH_MAX_KEYS * max_length);
+    for (uint32_t i = 0; i < BENCH_MAX_KEYS * max_length; ++i)
+    {
+        data[i] = (char)('a' + rand() % 26);
+    }
+    const char* keys[BENCH_MAX_KEYS];
+    size_t      lengths[BENCH_MAX_KEYS];
+    uint64_t    hashes[BENCH_MAX_KEYS];
+
+    printf("%8s %12s %12s %12s\n", "bytes", "murmur3 GB/s", "hash64 GB/s", "batch GB/s");
+    for (uint32_t l = 0; l < sizeof(key_lengths) / sizeof(key_lengths[0]); ++l)
+    {
+        uint32_t length   = key_lengths[l];
+        uint32_t num_keys = BENCH_MAX_KEYS;
+        for (uint32_t i = 0; i < num_keys; ++i)
+        {
+            keys[i]    = data + i * length;
+            lengths[i] = length;
+        }
+        uint32_t rounds    = (uint32_t)(BENCH_BYTES / ((uint64_t)num_keys * length));
+        uint64_t num_bytes = (uint64_t)rounds * num_keys * length;
+
+        uint64_t start = SDL_GetPerformanceCounter();
+        for (uint32_t r = 0; r < rounds; ++r)
+        {
+            for (uint32_t i = 0; i < num_keys; ++i)
+            {
+                checksum += murmur3_32((const uint8_t*)keys[i], length, SEED);
+            }
+        }
+        double murmur = get_gigabytes_per_second(start, num_bytes);
+
+        start = SDL_GetPerformanceCounter();
+        for (uint32_t r = 0; r < rounds; ++r)
+        {
+            for (uint32_t i = 0; i < num_keys; ++i)
+            {
+                checksum += hash64(keys[i], length);
+            }
+        }
+        double single = get_gigabytes_per_second(start, num_bytes);
+
+        start = SDL_GetPerformanceCounter();
+        for (uint32_t r = 0; r < rounds; ++r)
+        {
+            hash64_batch(keys, lengths, num_keys, hashes);
+            checksum += hashes[r % num_keys];
+        }
+        double batch = get_gigabytes_per_second(start, num_bytes);
+
+        printf("%8u %12.2f %12.2f %12.2f\n", length, murmur, single, batch);
+    }
+    printf("checksum %016llx\n", (unsigned long long)checksum);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+    Job queue benchmark. 1 to 64 producer threads submit BENCH_NUM_JOBS tiny jobs between them and
+    the time until all of them ran is taken, once through the job system and once through a copy of
+    the queue it replaced: one mutex and condition variable, a 256 job array that every pop shifts
+    down. The old queue had no bound check, the copy runs a job on the submitting thread when it is
+    full, as submit_job does.
+
+    g++ -O2 -std=c++14 -Isrc tools/bench/job_queue_bench.cpp src/thread.cpp src/memory.cpp
+        `sdl2-config --cflags --libs`
+*/
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <SDL_thread.h>
+#include <SDL_timer.h>
+
+#include "../../src/memory.h"
+#include "../../src/thread.h"
+
+#define BENCH_NUM_JOBS      (1 << 20)
+#define BENCH_MAX_PRODUCERS 64
+#define LOCKED_QUEUE_SIZE   256
+
+static std::atomic<uint32_t> jobs_run;
+
+static void bench_job(void* arg)
+{
+    jobs_run.fetch_add(1, std::memory_order_relaxed);
+}
+
+static SDL_mutex* locked_mutex;
+static SDL_cond*  locked_cond;
+static thread_job locked_queue[LOCKED_QUEUE_SIZE];
+static uint32_t   locked_num_jobs;
+
+static void submit_locked_job(thread_job job)
+{
+    SDL_LockMutex(locked_mutex);
+    if (locked_num_jobs == LOCKED_QUEUE_SIZE)
+    {
+        SDL_UnlockMutex(locked_mutex);
+        execute_job(&job);
+        return;
+    }
+    locked_queue[locked_num_jobs++] = job;
+    SDL_UnlockMutex(locked_mutex);
+    SDL_CondSignal(locked_cond);
+}
+
+static int locked_worker(void* arg)
+{
+    for (;;)
+    {
+        SDL_LockMutex(locked_mutex);
+        while (locked_num_jobs == 0)
+        {
+            SDL_CondWait(locked_cond, locked_mutex);
+        }
+        thread_job job = locked_queue[0];
+        for (uint32_t i = 0; i < locked_num_jobs - 1; ++i)
+        {
+            locked_queue[i] = locked_queue[i + 1];
+        }
+        locked_num_jobs--;
+        SDL_UnlockMutex(locked_mutex);
+        execute_job(&job);
+    }
+    return 0;
+}
+
+struct producer
+{
+    uint32_t    num_jobs;
+    bool        locked;
+    job_counter counter;
+};
+
+static int produce(void* arg)
+{
+    producer* p = (producer*)arg;
+    thread_job job = { &bench_job, NULL, NULL };
+    for (uint32_t i = 0; i < p->num_jobs; ++i)
+    {
+        if (p->locked)
+        {
+            submit_locked_job(job);
+        }
+        else
+        {
+            submit_job(job, &p->counter);
+        }
+    }
+    return 0;
+}
+
+//jobs per second from the first submit until the last job ran
+static double run(uint32_t num_producers, bool locked)
+{
+    static producer producers[BENCH_MAX_PRODUCERS];
+    SDL_Thread* threads[BENCH_MAX_PRODUCERS];
+    jobs_run.store(0);
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (uint32_t i = 0; i < num_producers; ++i)
+    {
+        producers[i].num_jobs = BENCH_NUM_JOBS / num_producers;
+        producers[i].locked   = locked;
+        producers[i].counter.value.store(0);
+        threads[i] = SDL_CreateThread(&produce, "Producer", producers + i);
+    }
+    for (uint32_t i = 0; i < num_producers; ++i)
+    {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    uint32_t total = (BENCH_NUM_JOBS / num_producers) * num_producers;
+    while (jobs_run.load(std::memory_order_relaxed) < total)
+    {
+        std::this_thread::yield();
+    }
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    return total / seconds;
+}
+
+int main(void)
+{
+    if (!game_memory_init())
+    {
+        printf("Can not allocate memory, quitting!\n");
+        return 2;
+    }
+    job_system_init();
+
+    locked_mutex = SDL_CreateMutex();
+    locked_cond  = SDL_CreateCond();
+    for (uint32_t i = 0; i < NUM_THREADS; ++i)
+    {
+        SDL_CreateThread(&locked_worker, "Locked worker", NULL);
+    }
+
+    printf("%u workers, %u jobs\n", NUM_THREADS, BENCH_NUM_JOBS);
+    printf("%9s %14s %14s\n", "producers", "ring Mjobs/s", "locked Mjobs/s");
+    for (uint32_t num_producers = 1; num_producers <= BENCH_MAX_PRODUCERS; num_producers *= 2)
+    {
+        double ring   = run(num_producers, false);
+        double locked = run(num_producers, true);
+        printf("%9u %14.2f %14.2f\n", num_producers, ring / 1e6, locked / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*
+    Pack benchmark. Writes a pack with one entry of synthetic animation keys, laid out like pos_key,
+    quat_key and scale_key (smooth curves sampled at 30 Hz, doubles for the times), and loads it back.
+    Prints the stored size and how fast a compressed load is, once before the job system is up
+    (every block on the calling thread) and once with NUM_THREADS workers helping, next to copying the
+    same bytes from memory, which is what a raw entry costs once its pages are in.
+
+    g++ -O2 -std=c++14 -Isrc tools/bench/pack_bench.cpp src/pack.cpp src/compress.cpp src/thread.cpp
+        src/memory.cpp src/asset.cpp src/hash.cpp `sdl2-config --cflags --libs`
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <SDL_timer.h>
+
+#include "../../src/memory.h"
+#include "../../src/asset.h"
+#include "../../src/pack.h"
+#include "../../src/thread.h"
+
+#define BENCH_PACK_PATH "bench.pak"
+#define BENCH_ASSET     "Assets/Meshes/Bench/keys.dae"
+#define BENCH_NUM_BONES 64
+#define BENCH_NUM_KEYS  4096
+#define BENCH_ROUNDS    20
+
+//same layout as the keys in mesh.h, without pulling in glm
+struct bench_vec_key
+{
+    float  value[3];
+    double time;
+};
+
+struct bench_quat_key
+{
+    float  value[4];
+    double time;
+};
+
+//through a pointer the compiler can't see through, so the copies aren't folded into one
+static void* (*volatile copy_bytes)(void*, const void*, size_t) = &memcpy;
+
+static double get_megabytes_per_second(uint64_t start, uint64_t num_bytes)
+{
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    return (double)num_bytes / seconds / 1e6;
+}
+
+static uint64_t fill_keys(uint8_t* dest)
+{
+    uint8_t* at = dest;
+    for (uint32_t bone = 0; bone < BENCH_NUM_BONES; ++bone)
+    {
+        bench_vec_key* positions = (bench_vec_key*)at;
+        at += BENCH_NUM_KEYS * sizeof(bench_vec_key);
+        bench_quat_key* rotations = (bench_quat_key*)at;
+        at += BENCH_NUM_KEYS * sizeof(bench_quat_key);
+        bench_vec_key* scales = (bench_vec_key*)at;
+        at += BENCH_NUM_KEYS * sizeof(bench_vec_key);
+        for (uint32_t i = 0; i < BENCH_NUM_KEYS; ++i)
+        {
+            double time = i / 30.0;
+            float  angle = (float)(sin(time * 0.7 + bone) * 0.5);
+            positions[i] = { { (float)bone, (float)sin(time + bone) * 0.1f, 0.0f }, time };
+            rotations[i] = { { cosf(angle), sinf(angle), 0.0f, 0.0f }, time };
+            scales[i]    = { { 1.0f, 1.0f, 1.0f }, time };
+        }
+    }
+    return (uint64_t)(at - dest);
+}
+
+static double measure_pack_load(uint64_t size)
+{
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (uint32_t r = 0; r < BENCH_ROUNDS; ++r)
+    {
+        uint64_t loaded_size = 0;
+        const void* loaded = pack_load(BENCH_ASSET, PACK_ENTRY_RAW, NULL, &loaded_size);
+        if (!loaded || loaded_size != size)
+        {
+            printf("Could not load the entry back\n");
+            exit(1);
+        }
+        pack_free(loaded);
+    }
+    return get_megabytes_per_second(start, size * BENCH_ROUNDS);
+}
+
+int main(void)
+{
+    if (!game_memory_init())
+    {
+        printf("Can not allocate memory, quitting!\n");
+        return 2;
+    }
+    asset_storage_init();
+
+    uint64_t capacity = (uint64_t)BENCH_NUM_BONES * BENCH_NUM_KEYS * (2 * sizeof(bench_vec_key) + sizeof(bench_quat_key));
+    uint8_t* keys = (uint8_t*)malloc(capacity);
+    uint64_t size = fill_keys(keys);
+
+    pack_source source = { BENCH_ASSET, keys, size, PACK_ENTRY_RAW };
+    if (!write_pack(BENCH_PACK_PATH, &source, 1) || !pack_open(BENCH_PACK_PATH))
+    {
+        printf("Could not write %s\n", BENCH_PACK_PATH);
+        return 1;
+    }
+    FILE* file = fopen(BENCH_PACK_PATH, "rb");
+    fseek(file, 0, SEEK_END);
+    long pack_size = ftell(file);
+    fclose(file);
+
+    uint8_t* copy = (uint8_t*)malloc(size);
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (uint32_t r = 0; r < BENCH_ROUNDS; ++r)
+    {
+        copy_bytes(copy, keys, size);
+    }
+    double raw = get_megabytes_per_second(start, size * BENCH_ROUNDS);
+
+    double serial = measure_pack_load(size);
+    job_system_init();
+    double parallel = measure_pack_load(size);
+
+    printf("keys            %8.2f MB\n", size / 1e6);
+    printf("pack file       %8.2f MB (%.1f%%)\n", pack_size / 1e6, 100.0 * pack_size / size);
+    printf("raw copy        %8.0f MB/s\n", raw);
+    printf("load, 1 thread  %8.0f MB/s\n", serial);
+    printf("load, %u workers %8.0f MB/s\n", NUM_THREADS, parallel);
+
+    pack_close();
+    remove(BENCH_PACK_PATH);
+    free(copy);
+    free(keys);
+    return 0;
+}
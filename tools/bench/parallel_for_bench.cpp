@@ -0,0 +1,117 @@
+/*
+    parallel_for benchmark. 10k synthetic entities are integrated and tested against a few hundred
+    walls for BENCH_FRAMES frames, once in a plain loop and once through parallel_for with the grain
+    picked for it. Build it with -DNUM_THREADS=1, 2, 4, 8 and so on for the scaling curve, the main
+    thread helps as well, so NUM_THREADS workers make NUM_THREADS + 1 threads.
+
+    g++ -O2 -std=c++14 -DNUM_THREADS=4 -Isrc tools/bench/parallel_for_bench.cpp src/thread.cpp
+        src/memory.cpp `sdl2-config --cflags --libs`
+*/
+#include <stdio.h>
+#include <math.h>
+#include <SDL_timer.h>
+
+#include "../../src/memory.h"
+#include "../../src/thread.h"
+
+#define BENCH_NUM_ENTITIES 10000
+#define BENCH_NUM_WALLS    256
+#define BENCH_FRAMES       200
+
+struct bench_entity
+{
+    float p[3];
+    float v[3];
+    float t_min;
+};
+
+struct bench_wall
+{
+    float normal[3];
+    float distance;
+};
+
+static bench_entity entities[BENCH_NUM_ENTITIES];
+static bench_wall   walls[BENCH_NUM_WALLS];
+
+//like a collision sweep: the earliest wall the entity runs into this step
+static void update_entities(uint32_t begin, uint32_t end, void* arg)
+{
+    float dt = *(float*)arg;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        bench_entity* e = entities + i;
+        float t_min = 1.0f;
+        for (uint32_t w = 0; w < BENCH_NUM_WALLS; ++w)
+        {
+            bench_wall* wall = walls + w;
+            float along = wall->normal[0] * e->v[0] + wall->normal[1] * e->v[1] + wall->normal[2] * e->v[2];
+            float gap = wall->distance - (wall->normal[0] * e->p[0] + wall->normal[1] * e->p[1] + wall->normal[2] * e->p[2]);
+            if (along > 0.0f && gap >= 0.0f && gap < along * dt * t_min)
+            {
+                t_min = gap / (along * dt);
+            }
+        }
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+            e->p[j] += e->v[j] * dt * t_min;
+        }
+        e->t_min = t_min;
+    }
+}
+
+static void reset_entities(void)
+{
+    for (uint32_t i = 0; i < BENCH_NUM_ENTITIES; ++i)
+    {
+        bench_entity* e = entities + i;
+        e->p[0] = (float)(i % 100);
+        e->p[1] = 0.0f;
+        e->p[2] = (float)(i / 100);
+        e->v[0] = sinf((float)i);
+        e->v[1] = 0.0f;
+        e->v[2] = cosf((float)i);
+    }
+}
+
+static double run(bool parallel)
+{
+    reset_entities();
+    float dt = 1.0f / 60.0f;
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (uint32_t frame = 0; frame < BENCH_FRAMES; ++frame)
+    {
+        if (parallel)
+        {
+            parallel_for(BENCH_NUM_ENTITIES, 0, &update_entities, &dt);
+        }
+        else
+        {
+            update_entities(0, BENCH_NUM_ENTITIES, &dt);
+        }
+    }
+    double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    return ms / BENCH_FRAMES;
+}
+
+int main(void)
+{
+    if (!game_memory_init())
+    {
+        printf("Can not allocate memory, quitting!\n");
+        return 2;
+    }
+    for (uint32_t w = 0; w < BENCH_NUM_WALLS; ++w)
+    {
+        float angle = (float)w * 6.2831853f / BENCH_NUM_WALLS;
+        walls[w] = { { cosf(angle), 0.0f, sinf(angle) }, 60.0f };
+    }
+    job_system_init();
+
+    double serial   = run(false);
+    double parallel = run(true);
+    printf("%u workers, %u entities\n", NUM_THREADS, BENCH_NUM_ENTITIES);
+    printf("serial        %8.3f ms/frame\n", serial);
+    printf("parallel_for  %8.3f ms/frame, %.2fx\n", parallel, serial / parallel);
+    return 0;
+}